@@ -0,0 +1,390 @@
+// Benchmarks for every step of the VOPRF protocol.
+//
+// Measures each C API call, (de)serialization of every object type, and the
+// underlying group operations, then sweeps the batch APIs over batch sizes
+// and thread counts. Results are written as JSON; a summary table goes to
+// stderr.
+//
+// Usage: bench_voprf [--iterations N] [--batch-sizes 1,16,256]
+//                    [--threads 1,2,4] [--output results.json]
+
+#include "voprf/voprf.h"
+
+#include "elements.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Result {
+        std::string name;
+        size_t batch_size;
+        size_t threads;
+        size_t iterations;
+        double ops_per_sec;
+        double p50_ns;
+        double p99_ns;
+    };
+
+    struct Options {
+        size_t iterations = 200;
+        std::vector<size_t> batch_sizes = {1, 16, 256};
+        std::vector<size_t> threads;
+        std::string output;
+    };
+
+    std::vector<Result> results;
+
+    void Check(int status, const char* what) {
+        if (status != 0) {
+            std::fprintf(stderr, "bench_voprf: %s failed with status %d\n", what, status);
+            std::exit(1);
+        }
+    }
+
+    double Percentile(const std::vector<double>& sorted, double p) {
+        size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+    // Times `iterations` calls of fn. Each call processes `batch_size`
+    // items, so throughput is reported in items per second while the
+    // percentiles are per call.
+    template <typename F>
+    void Measure(const std::string& name, size_t iterations, size_t batch_size, size_t threads, F fn) {
+        using clock = std::chrono::steady_clock;
+        std::vector<double> latencies;
+        latencies.reserve(iterations);
+
+        fn(); // warm-up
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            auto t0 = clock::now();
+            fn();
+            auto t1 = clock::now();
+            latencies.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+        }
+        double total = std::chrono::duration<double>(clock::now() - start).count();
+
+        std::sort(latencies.begin(), latencies.end());
+        Result r;
+        r.name = name;
+        r.batch_size = batch_size;
+        r.threads = threads;
+        r.iterations = iterations;
+        r.ops_per_sec = total > 0 ? static_cast<double>(iterations * batch_size) / total : 0;
+        r.p50_ns = Percentile(latencies, 0.50);
+        r.p99_ns = Percentile(latencies, 0.99);
+        results.push_back(r);
+
+        std::fprintf(stderr, "%-36s batch=%-5zu threads=%-3zu %12.0f ops/s  p50=%10.0f ns  p99=%10.0f ns\n",
+                     name.c_str(), batch_size, threads, r.ops_per_sec, r.p50_ns, r.p99_ns);
+    }
+
+    std::vector<size_t> ParseList(const char* s) {
+        std::vector<size_t> out;
+        std::stringstream ss(s);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            out.push_back(std::strtoull(item.c_str(), nullptr, 10));
+        }
+        return out;
+    }
+
+    Options ParseArgs(int argc, char** argv) {
+        Options opt;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "bench_voprf: missing value for %s\n", arg.c_str());
+                std::exit(2);
+            }
+            const char* value = argv[++i];
+            if (arg == "--iterations") {
+                opt.iterations = std::max<size_t>(std::strtoull(value, nullptr, 10), 1);
+            } else if (arg == "--batch-sizes") {
+                opt.batch_sizes = ParseList(value);
+            } else if (arg == "--threads") {
+                opt.threads = ParseList(value);
+            } else if (arg == "--output") {
+                opt.output = value;
+            } else {
+                std::fprintf(stderr, "bench_voprf: unknown option %s\n", arg.c_str());
+                std::exit(2);
+            }
+        }
+        if (opt.threads.empty()) {
+            size_t hw = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            for (size_t t = 1; t < hw; t *= 2) {
+                opt.threads.push_back(t);
+            }
+            opt.threads.push_back(hw);
+        }
+        return opt;
+    }
+
+    void WriteJson(std::ostream& out) {
+        out << "{\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            out << "    {\"name\": \"" << r.name << "\""
+                << ", \"batch_size\": " << r.batch_size
+                << ", \"threads\": " << r.threads
+                << ", \"iterations\": " << r.iterations
+                << ", \"ops_per_sec\": " << r.ops_per_sec
+                << ", \"p50_ns\": " << r.p50_ns
+                << ", \"p99_ns\": " << r.p99_ns << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+
+    std::vector<std::vector<uint8_t>> MakeMessages(size_t n) {
+        std::vector<std::vector<uint8_t>> msgs(n);
+        for (size_t i = 0; i < n; i++) {
+            std::string m = "bench message " + std::to_string(i);
+            msgs[i].assign(m.begin(), m.end());
+        }
+        return msgs;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt = ParseArgs(argc, argv);
+    const size_t iters = opt.iterations;
+
+    Check(voprf_init(), "voprf_init");
+
+    // Fixture: one full protocol run whose objects the single-call
+    // benchmarks reuse.
+    const char* msg = "benchmark input message";
+    const uint8_t* msg_bytes = reinterpret_cast<const uint8_t*>(msg);
+    size_t msg_len = std::strlen(msg);
+
+    voprf_private_key_t* sk = nullptr;
+    voprf_public_key_t* pk = nullptr;
+    voprf_private_key_t* r = nullptr;
+    voprf_point_t* blinded = nullptr;
+    voprf_point_t* evaluated = nullptr;
+    voprf_point_t* output = nullptr;
+    voprf_server_ctx_t* ctx = nullptr;
+    voprf_verifier_t* verifier = nullptr;
+    voprf_blind_pool_t* pool = nullptr;
+    Check(voprf_private_key_generate(&sk), "keygen");
+    Check(voprf_private_key_get_public_key(sk, &pk), "get public key");
+    Check(voprf_blind(msg_bytes, msg_len, &r, &blinded), "blind");
+    Check(voprf_evaluate(sk, blinded, &evaluated), "evaluate");
+    Check(voprf_unblind(evaluated, r, &output), "unblind");
+    Check(voprf_server_ctx_create(sk, &ctx), "server ctx");
+    Check(voprf_verifier_create(pk, &verifier), "verifier");
+    Check(voprf_blind_pool_create(iters + 1, false, &pool), "blind pool");
+
+    // ---- C API, one call at a time ----
+    Measure("voprf_private_key_generate", iters, 1, 1, [&] {
+        voprf_private_key_t* k = nullptr;
+        Check(voprf_private_key_generate(&k), "keygen");
+        voprf_private_key_destroy(k);
+    });
+    Measure("voprf_private_key_get_public_key", iters, 1, 1, [&] {
+        voprf_public_key_t* p = nullptr;
+        Check(voprf_private_key_get_public_key(sk, &p), "get public key");
+        voprf_public_key_destroy(p);
+    });
+    Measure("voprf_blind", iters, 1, 1, [&] {
+        voprf_private_key_t* rr = nullptr;
+        voprf_point_t* x = nullptr;
+        Check(voprf_blind(msg_bytes, msg_len, &rr, &x), "blind");
+        voprf_private_key_destroy(rr);
+        voprf_point_destroy(x);
+    });
+    Measure("voprf_evaluate", iters, 1, 1, [&] {
+        voprf_point_t* y = nullptr;
+        Check(voprf_evaluate(sk, blinded, &y), "evaluate");
+        voprf_point_destroy(y);
+    });
+    Measure("voprf_server_ctx_evaluate", iters, 1, 1, [&] {
+        voprf_point_t* y = nullptr;
+        Check(voprf_server_ctx_evaluate(ctx, blinded, &y), "ctx evaluate");
+        voprf_point_destroy(y);
+    });
+    Measure("voprf_unblind", iters, 1, 1, [&] {
+        voprf_point_t* z = nullptr;
+        Check(voprf_unblind(evaluated, r, &z), "unblind");
+        voprf_point_destroy(z);
+    });
+    Measure("voprf_verify", iters, 1, 1, [&] {
+        bool ok = false;
+        Check(voprf_verify(pk, msg_bytes, msg_len, output, &ok), "verify");
+        if (!ok) {
+            Check(-1, "verify result");
+        }
+    });
+    Measure("voprf_verifier_verify", iters, 1, 1, [&] {
+        bool ok = false;
+        Check(voprf_verifier_verify(verifier, msg_bytes, msg_len, output, &ok), "verifier verify");
+        if (!ok) {
+            Check(-1, "verifier verify result");
+        }
+    });
+    Check(voprf_blind_pool_fill(pool), "pool fill");
+    Measure("voprf_blind_pooled", iters, 1, 1, [&] {
+        voprf_private_key_t* rr = nullptr;
+        voprf_point_t* x = nullptr;
+        Check(voprf_blind_pooled(pool, msg_bytes, msg_len, &rr, &x), "blind pooled");
+        voprf_private_key_destroy(rr);
+        voprf_point_destroy(x);
+    });
+
+    // ---- Serialization ----
+    uint8_t sk_buf[VOPRF_PRIVATE_KEY_BYTES];
+    uint8_t pk_buf[VOPRF_PUBLIC_KEY_BYTES];
+    uint8_t pt_buf[VOPRF_POINT_BYTES];
+    Measure("voprf_private_key_to_bytes", iters, 1, 1, [&] {
+        Check(voprf_private_key_to_bytes(sk, sk_buf, sizeof(sk_buf)), "sk to bytes");
+    });
+    Measure("voprf_private_key_from_bytes", iters, 1, 1, [&] {
+        voprf_private_key_t* k = nullptr;
+        Check(voprf_private_key_from_bytes(&k, sk_buf, sizeof(sk_buf)), "sk from bytes");
+        voprf_private_key_destroy(k);
+    });
+    Measure("voprf_public_key_to_bytes", iters, 1, 1, [&] {
+        Check(voprf_public_key_to_bytes(pk, pk_buf, sizeof(pk_buf)), "pk to bytes");
+    });
+    Measure("voprf_public_key_from_bytes", iters, 1, 1, [&] {
+        voprf_public_key_t* p = nullptr;
+        Check(voprf_public_key_from_bytes(&p, pk_buf, sizeof(pk_buf)), "pk from bytes");
+        voprf_public_key_destroy(p);
+    });
+    Measure("voprf_point_to_bytes", iters, 1, 1, [&] {
+        Check(voprf_point_to_bytes(output, pt_buf, sizeof(pt_buf)), "point to bytes");
+    });
+    Measure("voprf_point_from_bytes", iters, 1, 1, [&] {
+        voprf_point_t* p = nullptr;
+        Check(voprf_point_from_bytes(&p, pt_buf, sizeof(pt_buf)), "point from bytes");
+        voprf_point_destroy(p);
+    });
+
+    // ---- Underlying group operations ----
+    voprf::SecretKey raw_sk = voprf::SecretKey::Keygen();
+    voprf::Point raw_pt = voprf::Point::HashToPoint(msg);
+    voprf::VerificationKey raw_pk = raw_sk.GetVerificationKey();
+    Measure("Point::HashToPoint", iters, 1, 1, [&] {
+        raw_pt = voprf::Point::HashToPoint(msg);
+    });
+    Measure("Point::Mul", iters, 1, 1, [&] {
+        raw_pt = voprf::Point::Mul(raw_pt, raw_sk);
+    });
+    Measure("Pairing::Pair", iters, 1, 1, [&] {
+        voprf::Pairing e = voprf::Pairing::Pair(raw_pt, raw_pk);
+        (void)e;
+    });
+    Measure("Pairing::Check", iters, 1, 1, [&] {
+        bool ok = voprf::Pairing::Check(raw_pt, raw_pk, raw_pt);
+        (void)ok;
+    });
+
+    // ---- Batch APIs, swept over batch size and thread count ----
+    for (size_t n : opt.batch_sizes) {
+        if (n == 0) {
+            continue;
+        }
+        std::vector<std::vector<uint8_t>> msgs = MakeMessages(n);
+        std::vector<const uint8_t*> msg_ptrs(n);
+        std::vector<size_t> msg_lens(n);
+        for (size_t i = 0; i < n; i++) {
+            msg_ptrs[i] = msgs[i].data();
+            msg_lens[i] = msgs[i].size();
+        }
+
+        std::vector<uint8_t> r_storage(n * voprf_private_key_sizeof() + voprf_private_key_alignof());
+        std::vector<uint8_t> x_storage(n * voprf_point_sizeof() + voprf_point_alignof());
+        std::vector<uint8_t> y_storage(n * voprf_point_sizeof() + voprf_point_alignof());
+        std::vector<uint8_t> z_storage(n * voprf_point_sizeof() + voprf_point_alignof());
+        auto aligned = [](std::vector<uint8_t>& v, size_t align) {
+            uintptr_t p = reinterpret_cast<uintptr_t>(v.data());
+            return reinterpret_cast<void*>((p + align - 1) / align * align);
+        };
+        voprf_private_key_t* rs = nullptr;
+        voprf_point_t* xs = nullptr;
+        voprf_point_t* ys = nullptr;
+        voprf_point_t* zs = nullptr;
+        Check(voprf_private_key_array_init(aligned(r_storage, voprf_private_key_alignof()), n * voprf_private_key_sizeof(), n, &rs), "key array");
+        Check(voprf_point_array_init(aligned(x_storage, voprf_point_alignof()), n * voprf_point_sizeof(), n, &xs), "point array");
+        Check(voprf_point_array_init(aligned(y_storage, voprf_point_alignof()), n * voprf_point_sizeof(), n, &ys), "point array");
+        Check(voprf_point_array_init(aligned(z_storage, voprf_point_alignof()), n * voprf_point_sizeof(), n, &zs), "point array");
+
+        std::vector<const voprf_point_t*> x_ptrs(n);
+        std::vector<voprf_point_t*> y_ptrs(n);
+        std::vector<const voprf_point_t*> z_ptrs(n);
+        for (size_t i = 0; i < n; i++) {
+            x_ptrs[i] = voprf_point_array_at(xs, i);
+            y_ptrs[i] = voprf_point_array_at(ys, i);
+            z_ptrs[i] = voprf_point_array_at(zs, i);
+        }
+        std::vector<voprf_point_t*> out(n);
+        std::unique_ptr<bool[]> ok(new bool[n]);
+
+        Check(voprf_blind_batch(msg_ptrs.data(), msg_lens.data(), n, rs, xs, 0), "blind batch");
+        Check(voprf_server_ctx_evaluate_batch_into(ctx, x_ptrs.data(), n, y_ptrs.data(), 0), "evaluate batch");
+        Check(voprf_unblind_batch(ys, rs, n, zs, 0), "unblind batch");
+
+        for (size_t t : opt.threads) {
+            size_t batch_iters = std::max<size_t>(iters / n, 3);
+            Measure("voprf_blind_batch", batch_iters, n, t, [&] {
+                Check(voprf_blind_batch(msg_ptrs.data(), msg_lens.data(), n, rs, xs, t), "blind batch");
+            });
+            Measure("voprf_evaluate_batch", batch_iters, n, t, [&] {
+                Check(voprf_evaluate_batch(sk, x_ptrs.data(), n, out.data(), t), "evaluate batch");
+                for (voprf_point_t* p : out) {
+                    voprf_point_destroy(p);
+                }
+            });
+            Measure("voprf_server_ctx_evaluate_batch_into", batch_iters, n, t, [&] {
+                Check(voprf_server_ctx_evaluate_batch_into(ctx, x_ptrs.data(), n, y_ptrs.data(), t), "ctx evaluate batch");
+            });
+            Measure("voprf_unblind_batch", batch_iters, n, t, [&] {
+                Check(voprf_unblind_batch(ys, rs, n, zs, t), "unblind batch");
+            });
+            Measure("voprf_verify_batch", batch_iters, n, t, [&] {
+                bool all_valid = false;
+                Check(voprf_verify_batch(pk, msg_ptrs.data(), msg_lens.data(), z_ptrs.data(), n, ok.get(), &all_valid, t), "verify batch");
+                if (!all_valid) {
+                    Check(-1, "verify batch result");
+                }
+            });
+        }
+
+        voprf_private_key_array_deinit(rs, n);
+        voprf_point_array_deinit(xs, n);
+        voprf_point_array_deinit(ys, n);
+        voprf_point_array_deinit(zs, n);
+    }
+
+    if (opt.output.empty()) {
+        WriteJson(std::cout);
+    } else {
+        std::ofstream file(opt.output);
+        WriteJson(file);
+    }
+
+    voprf_blind_pool_destroy(pool);
+    voprf_verifier_destroy(verifier);
+    voprf_server_ctx_destroy(ctx);
+    voprf_point_destroy(output);
+    voprf_point_destroy(evaluated);
+    voprf_point_destroy(blinded);
+    voprf_private_key_destroy(r);
+    voprf_public_key_destroy(pk);
+    voprf_private_key_destroy(sk);
+    return 0;
+}
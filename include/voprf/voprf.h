@@ -9,6 +9,55 @@
 extern "C" {
 #endif
 
+//----------------------------------------------------------------
+// Serialized Sizes
+//----------------------------------------------------------------
+//
+// The library is built for one curve, BN254 unless configured otherwise. A
+// build for BLS12-381 defines VOPRF_CURVE_BLS12_381, which is propagated to
+// code linking against it.
+
+#if defined(VOPRF_CURVE_BLS12_381)
+/** @brief The name of the curve the library was built for. */
+#define VOPRF_CURVE_NAME "BLS12-381"
+
+/** @brief The size in bytes of a serialized private key. */
+#define VOPRF_PRIVATE_KEY_BYTES 32
+
+/** @brief The size in bytes of a serialized public key. */
+#define VOPRF_PUBLIC_KEY_BYTES 96
+
+/** @brief The size in bytes of a serialized point. */
+#define VOPRF_POINT_BYTES 48
+
+/** @brief The size in bytes of a public key in uncompressed (affine x, y) form. */
+#define VOPRF_PUBLIC_KEY_UNCOMPRESSED_BYTES 192
+
+/** @brief The size in bytes of a point in uncompressed (affine x, y) form. */
+#define VOPRF_POINT_UNCOMPRESSED_BYTES 96
+#else
+/** @brief The name of the curve the library was built for. */
+#define VOPRF_CURVE_NAME "BN254"
+
+/** @brief The size in bytes of a serialized private key. */
+#define VOPRF_PRIVATE_KEY_BYTES 32
+
+/** @brief The size in bytes of a serialized public key. */
+#define VOPRF_PUBLIC_KEY_BYTES 64
+
+/** @brief The size in bytes of a serialized point. */
+#define VOPRF_POINT_BYTES 32
+
+/** @brief The size in bytes of a public key in uncompressed (affine x, y) form. */
+#define VOPRF_PUBLIC_KEY_UNCOMPRESSED_BYTES 128
+
+/** @brief The size in bytes of a point in uncompressed (affine x, y) form. */
+#define VOPRF_POINT_UNCOMPRESSED_BYTES 64
+#endif
+
+/** @brief The size in bytes of a serialized DLEQ proof. */
+#define VOPRF_PROOF_BYTES 64
+
 //----------------------------------------------------------------
 // Opaque Type Definitions
 //----------------------------------------------------------------
@@ -22,6 +71,27 @@ typedef struct voprf_public_key_t voprf_public_key_t;
 /** @brief An opaque pointer to an elliptic curve point object. */
 typedef struct voprf_point_t voprf_point_t;
 
+/** @brief An opaque pointer to a server context prepared from a private key. */
+typedef struct voprf_server_ctx_t voprf_server_ctx_t;
+
+/** @brief An opaque pointer to a verifier prepared from a public key. */
+typedef struct voprf_verifier_t voprf_verifier_t;
+
+/** @brief An opaque pointer to a pool of precomputed blinding factors. */
+typedef struct voprf_blind_pool_t voprf_blind_pool_t;
+
+/** @brief An opaque pointer to a cache of hash-to-point results. */
+typedef struct voprf_hash_cache_t voprf_hash_cache_t;
+
+/** @brief An opaque pointer to a set of server keys indexed by key ID. */
+typedef struct voprf_keyring_t voprf_keyring_t;
+
+/** @brief An opaque pointer to a memory-mapped store of per-tenant keys. */
+typedef struct voprf_key_store_t voprf_key_store_t;
+
+/** @brief An opaque pointer to an asynchronous job engine. */
+typedef struct voprf_engine_t voprf_engine_t;
+
 //----------------------------------------------------------------
 // Global Library Initialization
 //----------------------------------------------------------------
@@ -67,6 +137,8 @@ int voprf_private_key_get_public_key(const voprf_private_key_t* private_key, vop
 /**
  * @brief Gets the required buffer size for serializing a private key.
  *
+ * The size is always `VOPRF_PRIVATE_KEY_BYTES`.
+ *
  * @param[in] key The private key object.
  * @param[out] size A pointer to store the required size in bytes.
  * @return 0 on success, non-zero on failure.
@@ -111,6 +183,8 @@ void voprf_public_key_destroy(voprf_public_key_t* key);
 /**
  * @brief Gets the required buffer size for serializing a public key.
  *
+ * The size is always `VOPRF_PUBLIC_KEY_BYTES`.
+ *
  * @param[in] key The public key object.
  * @param[out] size A pointer to store the required size in bytes.
  * @return 0 on success, non-zero on failure.
@@ -152,6 +226,8 @@ void voprf_point_destroy(voprf_point_t* point);
 /**
  * @brief Gets the required buffer size for serializing a point.
  *
+ * The size is always `VOPRF_POINT_BYTES`.
+ *
  * @param[in] point The point object.
  * @param[out] size A pointer to store the required size in bytes.
  * @return 0 on success, non-zero on failure.
@@ -192,6 +268,22 @@ int voprf_point_equal(const voprf_point_t* p1, const voprf_point_t* p2, bool* eq
 // Core VOPRF Operations
 //----------------------------------------------------------------
 
+/**
+ * @brief Hashes a batch of messages to curve points.
+ *
+ * Computes the same mapping `voprf_blind` and `voprf_verify` apply to their
+ * input, with the map-to-curve step spread over `num_threads` worker
+ * threads. Messages are read in place; no copies are made.
+ *
+ * @param[in] msgs An array of `n` input messages.
+ * @param[in] msg_lens An array of `n` message lengths.
+ * @param[in] n The number of messages in the batch.
+ * @param[out] points An array of `n` objects (see `voprf_point_array_init`) to receive the points.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_hash_to_point_batch(const uint8_t* const* msgs, const size_t* msg_lens, size_t n, voprf_point_t* points, size_t num_threads);
+
 /**
  * @brief Hashes an input message and blinds it.
  *
@@ -205,6 +297,23 @@ int voprf_point_equal(const voprf_point_t* p1, const voprf_point_t* p2, bool* eq
  */
 int voprf_blind(const uint8_t* msg, size_t msg_len, voprf_private_key_t** blinding_factor, voprf_point_t** blinded_point);
 
+/**
+ * @brief Hashes and blinds a batch of messages.
+ *
+ * Results are written into contiguous arrays created with
+ * `voprf_private_key_array_init` and `voprf_point_array_init`. Hashing and
+ * blinding are spread over `num_threads` worker threads.
+ *
+ * @param[in] msgs An array of `n` input messages.
+ * @param[in] msg_lens An array of `n` message lengths.
+ * @param[in] n The number of messages in the batch.
+ * @param[out] blinding_factors An array of `n` objects to receive the blinding factors.
+ * @param[out] blinded_points An array of `n` objects to receive the blinded points.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_blind_batch(const uint8_t* const* msgs, const size_t* msg_lens, size_t n, voprf_private_key_t* blinding_factors, voprf_point_t* blinded_points, size_t num_threads);
+
 /**
  * @brief Evaluates the OPRF function on a blinded point.
  *
@@ -217,6 +326,23 @@ int voprf_blind(const uint8_t* msg, size_t msg_len, voprf_private_key_t** blindi
  */
 int voprf_evaluate(const voprf_private_key_t* sk, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point);
 
+/**
+ * @brief Evaluates the OPRF function on a batch of blinded points.
+ *
+ * Equivalent to calling `voprf_evaluate` on every input, but the work is spread
+ * over `num_threads` worker threads. Each `out[i]` receives a new point object
+ * that must be released with `voprf_point_destroy`. On failure no output
+ * objects are left allocated and every `out[i]` is set to NULL.
+ *
+ * @param[in] sk The server's private key.
+ * @param[in] in An array of `n` blinded points received from clients.
+ * @param[in] n The number of points in the batch.
+ * @param[out] out An array of `n` pointers to receive the evaluated points.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_evaluate_batch(const voprf_private_key_t* sk, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads);
+
 /**
  * @brief Unblinds an evaluated point to get the final OPRF output.
  *
@@ -229,6 +355,22 @@ int voprf_evaluate(const voprf_private_key_t* sk, const voprf_point_t* blinded_p
  */
 int voprf_unblind(const voprf_point_t* evaluated_point, const voprf_private_key_t* blinding_factor, voprf_point_t** final_output);
 
+/**
+ * @brief Unblinds a batch of evaluated points.
+ *
+ * All blinding factors are inverted together with a single field inversion.
+ * Inputs and outputs are contiguous arrays created with
+ * `voprf_private_key_array_init` and `voprf_point_array_init`.
+ *
+ * @param[in] evaluated_points An array of `n` points received from the server.
+ * @param[in] blinding_factors An array of `n` blinding factors from `voprf_blind_batch`.
+ * @param[in] n The number of points in the batch.
+ * @param[out] final_outputs An array of `n` objects to receive the OPRF outputs.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure (including a zero blinding factor).
+ */
+int voprf_unblind_batch(const voprf_point_t* evaluated_points, const voprf_private_key_t* blinding_factors, size_t n, voprf_point_t* final_outputs, size_t num_threads);
+
 /**
  * @brief Verifies that an OPRF output corresponds to a given input and public key.
  *
@@ -241,6 +383,1352 @@ int voprf_unblind(const voprf_point_t* evaluated_point, const voprf_private_key_
  */
 int voprf_verify(const voprf_public_key_t* pk, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result);
 
+/**
+ * @brief Verifies a batch of OPRF outputs against a single public key.
+ *
+ * All `n` checks are folded into one using a random linear combination, so
+ * the cost is roughly two multi-scalar multiplications and one pairing check
+ * instead of `n` verifications. When `results` is non-NULL and the combined
+ * check fails, the batch is bisected to find which entries are invalid.
+ * Message hashing is spread over `num_threads` worker threads.
+ *
+ * @param[in] pk The server's public key.
+ * @param[in] input_msgs An array of `n` input messages.
+ * @param[in] input_msg_lens An array of `n` message lengths.
+ * @param[in] output_points An array of `n` OPRF output points to verify.
+ * @param[in] n The number of entries in the batch.
+ * @param[out] results An optional array of `n` per-entry results. Can be NULL.
+ * @param[out] all_valid A pointer to store whether every entry verified.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verify_batch(const voprf_public_key_t* pk, const uint8_t* const* input_msgs, const size_t* input_msg_lens, const voprf_point_t* const* output_points, size_t n, bool* results, bool* all_valid, size_t num_threads);
+
+//----------------------------------------------------------------
+// Prepared Server Context
+//----------------------------------------------------------------
+
+/**
+ * @brief Prepares a private key for repeated evaluation.
+ *
+ * The context holds its own copy of the key along with per-key precomputed
+ * state, so evaluating through it is cheaper than `voprf_evaluate`. The
+ * private key may be destroyed once the context has been created. A context
+ * is immutable after creation and may be shared between threads.
+ *
+ * @param[in] sk The server's private key.
+ * @param[out] ctx A pointer to receive the newly created server context.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_create(const voprf_private_key_t* sk, voprf_server_ctx_t** ctx);
+
+/**
+ * @brief Destroys a server context and frees its memory.
+ *
+ * @param ctx The server context to destroy. Can be NULL.
+ */
+void voprf_server_ctx_destroy(voprf_server_ctx_t* ctx);
+
+/**
+ * @brief Evaluates the OPRF function on a blinded point using a prepared context.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[in] blinded_point The blinded point received from the client.
+ * @param[out] evaluated_point A pointer to receive the resulting evaluated point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_evaluate(const voprf_server_ctx_t* ctx, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point);
+
+/**
+ * @brief Evaluates a batch of blinded points using a prepared context.
+ *
+ * Behaves like `voprf_evaluate_batch`.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[in] in An array of `n` blinded points received from clients.
+ * @param[in] n The number of points in the batch.
+ * @param[out] out An array of `n` pointers to receive the evaluated points.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_evaluate_batch(const voprf_server_ctx_t* ctx, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads);
+
+
+//----------------------------------------------------------------
+// Prepared Verifier
+//----------------------------------------------------------------
+
+/**
+ * @brief Prepares a public key for repeated verification.
+ *
+ * The verifier holds its own copy of the key along with its precomputed
+ * pairing state, so verifying through it is cheaper than `voprf_verify`. The
+ * public key may be destroyed once the verifier has been created. A verifier
+ * is immutable after creation and may be shared between threads.
+ *
+ * @param[in] pk The server's public key.
+ * @param[out] verifier A pointer to receive the newly created verifier.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verifier_create(const voprf_public_key_t* pk, voprf_verifier_t** verifier);
+
+/**
+ * @brief Destroys a verifier and frees its memory.
+ *
+ * @param verifier The verifier to destroy. Can be NULL.
+ */
+void voprf_verifier_destroy(voprf_verifier_t* verifier);
+
+/**
+ * @brief Verifies an OPRF output using a prepared verifier.
+ *
+ * Behaves like `voprf_verify`.
+ *
+ * @param[in] verifier The prepared verifier.
+ * @param[in] input_msg The original input message.
+ * @param[in] input_msg_len The length of the input message.
+ * @param[in] output_point The final OPRF output point to verify.
+ * @param[out] result A pointer to store the boolean verification result.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verifier_verify(const voprf_verifier_t* verifier, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result);
+
+/**
+ * @brief Verifies a batch of OPRF outputs using a prepared verifier.
+ *
+ * Behaves like `voprf_verify_batch`.
+ *
+ * @param[in] verifier The prepared verifier.
+ * @param[in] input_msgs An array of `n` input messages.
+ * @param[in] input_msg_lens An array of `n` message lengths.
+ * @param[in] output_points An array of `n` OPRF output points to verify.
+ * @param[in] n The number of entries in the batch.
+ * @param[out] results An optional array of `n` per-entry results. Can be NULL.
+ * @param[out] all_valid A pointer to store whether every entry verified.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verifier_verify_batch(const voprf_verifier_t* verifier, const uint8_t* const* input_msgs, const size_t* input_msg_lens, const voprf_point_t* const* output_points, size_t n, bool* results, bool* all_valid, size_t num_threads);
+
+//----------------------------------------------------------------
+// Caller-Provided Storage
+//----------------------------------------------------------------
+//
+// These functions let callers place objects in memory they own (stack
+// slots, arrays, arenas) instead of having the library allocate them.
+// Storage must be at least `*_sizeof()` bytes and aligned to `*_alignof()`.
+// An object created with `*_init` must be released with `*_deinit`, never
+// `*_destroy`; the storage itself remains owned by the caller.
+
+/**
+ * @brief Gets the storage size in bytes required for a private key object.
+ */
+size_t voprf_private_key_sizeof(void);
+
+/**
+ * @brief Gets the storage alignment in bytes required for a private key object.
+ */
+size_t voprf_private_key_alignof(void);
+
+/**
+ * @brief Initializes a private key object in caller-provided storage.
+ *
+ * @param[in] storage The memory to place the object in.
+ * @param[in] storage_len The size of `storage` in bytes.
+ * @param[out] key A pointer to receive the initialized object.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_private_key_init(void* storage, size_t storage_len, voprf_private_key_t** key);
+
+/**
+ * @brief Releases a private key object created with `voprf_private_key_init`.
+ *
+ * Does not free the underlying storage.
+ *
+ * @param key The object to release. Can be NULL.
+ */
+void voprf_private_key_deinit(voprf_private_key_t* key);
+
+/**
+ * @brief Gets the storage size in bytes required for a public key object.
+ */
+size_t voprf_public_key_sizeof(void);
+
+/**
+ * @brief Gets the storage alignment in bytes required for a public key object.
+ */
+size_t voprf_public_key_alignof(void);
+
+/**
+ * @brief Initializes a public key object in caller-provided storage.
+ *
+ * @param[in] storage The memory to place the object in.
+ * @param[in] storage_len The size of `storage` in bytes.
+ * @param[out] key A pointer to receive the initialized object.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_public_key_init(void* storage, size_t storage_len, voprf_public_key_t** key);
+
+/**
+ * @brief Releases a public key object created with `voprf_public_key_init`.
+ *
+ * Does not free the underlying storage.
+ *
+ * @param key The object to release. Can be NULL.
+ */
+void voprf_public_key_deinit(voprf_public_key_t* key);
+
+/**
+ * @brief Gets the storage size in bytes required for a point object.
+ */
+size_t voprf_point_sizeof(void);
+
+/**
+ * @brief Gets the storage alignment in bytes required for a point object.
+ */
+size_t voprf_point_alignof(void);
+
+/**
+ * @brief Initializes a point object in caller-provided storage.
+ *
+ * @param[in] storage The memory to place the object in.
+ * @param[in] storage_len The size of `storage` in bytes.
+ * @param[out] point A pointer to receive the initialized object.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_point_init(void* storage, size_t storage_len, voprf_point_t** point);
+
+/**
+ * @brief Releases a point object created with `voprf_point_init`.
+ *
+ * Does not free the underlying storage.
+ *
+ * @param point The object to release. Can be NULL.
+ */
+void voprf_point_deinit(voprf_point_t* point);
+
+/**
+ * @brief Initializes a contiguous array of private key objects in caller-provided storage.
+ *
+ * Storage must be at least `n * voprf_private_key_sizeof()` bytes and aligned to
+ * `voprf_private_key_alignof()`. Such arrays are used by the batch client API.
+ *
+ * @param[in] storage The memory to place the objects in.
+ * @param[in] storage_len The size of `storage` in bytes.
+ * @param[in] n The number of objects in the array. Must be non-zero.
+ * @param[out] array A pointer to receive the first object of the array.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_private_key_array_init(void* storage, size_t storage_len, size_t n, voprf_private_key_t** array);
+
+/**
+ * @brief Releases an array created with `voprf_private_key_array_init`.
+ *
+ * Does not free the underlying storage.
+ *
+ * @param array The first object of the array. Can be NULL.
+ * @param n The number of objects in the array.
+ */
+void voprf_private_key_array_deinit(voprf_private_key_t* array, size_t n);
+
+/**
+ * @brief Gets the object at `index` in an array created with `voprf_private_key_array_init`.
+ *
+ * @param array The first object of the array.
+ * @param index The index of the object. Must be less than the array length.
+ * @return A pointer to the object, or NULL if `array` is NULL.
+ */
+voprf_private_key_t* voprf_private_key_array_at(voprf_private_key_t* array, size_t index);
+
+/**
+ * @brief Initializes a contiguous array of point objects in caller-provided storage.
+ *
+ * Storage must be at least `n * voprf_point_sizeof()` bytes and aligned to
+ * `voprf_point_alignof()`. Such arrays are used by the batch client API.
+ *
+ * @param[in] storage The memory to place the objects in.
+ * @param[in] storage_len The size of `storage` in bytes.
+ * @param[in] n The number of objects in the array. Must be non-zero.
+ * @param[out] array A pointer to receive the first object of the array.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_point_array_init(void* storage, size_t storage_len, size_t n, voprf_point_t** array);
+
+/**
+ * @brief Releases an array created with `voprf_point_array_init`.
+ *
+ * Does not free the underlying storage.
+ *
+ * @param array The first object of the array. Can be NULL.
+ * @param n The number of objects in the array.
+ */
+void voprf_point_array_deinit(voprf_point_t* array, size_t n);
+
+/**
+ * @brief Gets the object at `index` in an array created with `voprf_point_array_init`.
+ *
+ * @param array The first object of the array.
+ * @param index The index of the object. Must be less than the array length.
+ * @return A pointer to the object, or NULL if `array` is NULL.
+ */
+voprf_point_t* voprf_point_array_at(voprf_point_t* array, size_t index);
+
+//----------------------------------------------------------------
+// In-Place Operations
+//----------------------------------------------------------------
+//
+// Variants of the functions above that write their results into existing
+// objects, created either with `*_init` or by the allocating API.
+
+/**
+ * @brief Generates a new, random private key into an existing object.
+ *
+ * @param[out] key The object to receive the key.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_private_key_generate_into(voprf_private_key_t* key);
+
+/**
+ * @brief Derives the public key of a private key into an existing object.
+ *
+ * @param[in] private_key The private key.
+ * @param[out] public_key The object to receive the public key.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_private_key_get_public_key_into(const voprf_private_key_t* private_key, voprf_public_key_t* public_key);
+
+/**
+ * @brief Deserializes a private key into an existing object.
+ *
+ * @param[out] key The object to receive the key.
+ * @param[in] buffer The buffer containing the serialized key.
+ * @param[in] buffer_len The size of the input buffer.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_private_key_from_bytes_into(voprf_private_key_t* key, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Deserializes a public key into an existing object.
+ *
+ * @param[out] key The object to receive the key.
+ * @param[in] buffer The buffer containing the serialized key.
+ * @param[in] buffer_len The size of the input buffer.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_public_key_from_bytes_into(voprf_public_key_t* key, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Deserializes a point into an existing object.
+ *
+ * @param[out] point The object to receive the point.
+ * @param[in] buffer The buffer containing the serialized point.
+ * @param[in] buffer_len The size of the input buffer.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_point_from_bytes_into(voprf_point_t* point, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Hashes and blinds a message into existing objects.
+ *
+ * @param[in] msg The input message buffer.
+ * @param[in] msg_len The length of the input message.
+ * @param[out] blinding_factor The object to receive the random blinding factor.
+ * @param[out] blinded_point The object to receive the blinded point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_blind_into(const uint8_t* msg, size_t msg_len, voprf_private_key_t* blinding_factor, voprf_point_t* blinded_point);
+
+/**
+ * @brief Evaluates a blinded point into an existing object.
+ *
+ * @param[in] sk The server's private key.
+ * @param[in] blinded_point The blinded point received from the client.
+ * @param[out] evaluated_point The object to receive the evaluated point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_evaluate_into(const voprf_private_key_t* sk, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point);
+
+/**
+ * @brief Unblinds an evaluated point into an existing object.
+ *
+ * @param[in] evaluated_point The point received from the server.
+ * @param[in] blinding_factor The blinding factor generated in the blind step.
+ * @param[out] final_output The object to receive the final OPRF output.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_unblind_into(const voprf_point_t* evaluated_point, const voprf_private_key_t* blinding_factor, voprf_point_t* final_output);
+
+/**
+ * @brief Evaluates a blinded point into an existing object using a prepared context.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[in] blinded_point The blinded point received from the client.
+ * @param[out] evaluated_point The object to receive the evaluated point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_evaluate_into(const voprf_server_ctx_t* ctx, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point);
+
+/**
+ * @brief Evaluates a batch of blinded points into existing objects using a prepared context.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[in] in An array of `n` blinded points received from clients.
+ * @param[in] n The number of points in the batch.
+ * @param[out] out An array of `n` existing objects to receive the evaluated points.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_evaluate_batch_into(const voprf_server_ctx_t* ctx, const voprf_point_t* const* in, size_t n, voprf_point_t* const* out, size_t num_threads);
+
+//----------------------------------------------------------------
+// Wire Formats
+//----------------------------------------------------------------
+//
+// Tagged encodings that carry their format in a leading byte. The default
+// `*_to_bytes` encoding is compressed, so every decode computes a field
+// square root; the uncompressed format is twice the size but decodes with
+// only a curve equation check, which suits server-to-server traffic and
+// storage. Each format has a constant encoded size.
+
+/** @brief How thoroughly deserialized points are checked. */
+typedef enum voprf_validation {
+    /** Full validation, including the subgroup check. Use for any untrusted input. */
+    VOPRF_VALIDATE_STRICT = 0,
+    /** Decoding only; the subgroup check is skipped. Use only for data this process or its own storage produced. */
+    VOPRF_VALIDATE_TRUSTED = 1
+} voprf_validation;
+
+/** @brief The encoding of a point or public key. The value is also the tag byte. */
+typedef enum voprf_format {
+    /** The compressed encoding used by `voprf_point_to_bytes`. */
+    VOPRF_FORMAT_COMPRESSED = 1,
+    /** Affine x and y; larger, but decoding needs no square root. */
+    VOPRF_FORMAT_UNCOMPRESSED = 2
+} voprf_format;
+
+/** @brief The size in bytes of a tagged point in the given format. */
+#define VOPRF_POINT_TAGGED_BYTES(format) \
+    (1 + ((format) == VOPRF_FORMAT_UNCOMPRESSED ? VOPRF_POINT_UNCOMPRESSED_BYTES : VOPRF_POINT_BYTES))
+
+/** @brief The size in bytes of a tagged public key in the given format. */
+#define VOPRF_PUBLIC_KEY_TAGGED_BYTES(format) \
+    (1 + ((format) == VOPRF_FORMAT_UNCOMPRESSED ? VOPRF_PUBLIC_KEY_UNCOMPRESSED_BYTES : VOPRF_PUBLIC_KEY_BYTES))
+
+/**
+ * @brief Serializes a point with a leading format tag.
+ *
+ * @param[in] point The point to serialize.
+ * @param[in] format The encoding to use.
+ * @param[out] buffer The buffer to write the tagged encoding into.
+ * @param[in] buffer_len The size of the buffer; at least `VOPRF_POINT_TAGGED_BYTES(format)`.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_point_to_tagged_bytes(const voprf_point_t* point, voprf_format format, uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Deserializes a tagged point into an existing object.
+ *
+ * The format is read from the tag byte.
+ *
+ * @param[out] point The object to receive the point.
+ * @param[in] buffer The buffer containing the tagged encoding.
+ * @param[in] buffer_len The size of the input buffer.
+ * @param[in] mode The validation mode.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_point_from_tagged_bytes_into(voprf_point_t* point, const uint8_t* buffer, size_t buffer_len, voprf_validation mode);
+
+/**
+ * @brief Serializes a public key with a leading format tag.
+ *
+ * @param[in] key The public key to serialize.
+ * @param[in] format The encoding to use.
+ * @param[out] buffer The buffer to write the tagged encoding into.
+ * @param[in] buffer_len The size of the buffer; at least `VOPRF_PUBLIC_KEY_TAGGED_BYTES(format)`.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_public_key_to_tagged_bytes(const voprf_public_key_t* key, voprf_format format, uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief Deserializes a tagged public key into an existing object.
+ *
+ * @param[out] key The object to receive the key.
+ * @param[in] buffer The buffer containing the tagged encoding.
+ * @param[in] buffer_len The size of the input buffer.
+ * @param[in] mode The validation mode.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_public_key_from_tagged_bytes_into(voprf_public_key_t* key, const uint8_t* buffer, size_t buffer_len, voprf_validation mode);
+
+//----------------------------------------------------------------
+// Batch Serialization
+//----------------------------------------------------------------
+
+/**
+ * @brief Deserializes `n` concatenated points into an existing array.
+ *
+ * Reads the untagged layout written by `voprf_points_to_bytes`: point `i`
+ * occupies bytes `[i * size, (i + 1) * size)`, where `size` is
+ * `VOPRF_POINT_BYTES` for the compressed format and
+ * `VOPRF_POINT_UNCOMPRESSED_BYTES` otherwise. Decoding and validation are
+ * spread over `num_threads` worker threads. `points` is typically created
+ * with `voprf_point_array_init`. On failure the contents of `points` are
+ * unspecified.
+ *
+ * @param[in] buffer The serialized points.
+ * @param[in] buffer_len The size of the buffer; at least `n * size`.
+ * @param[in] n The number of points.
+ * @param[in] format The encoding of the points.
+ * @param[out] points An array of `n` point objects to receive the points.
+ * @param[in] mode The validation mode.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @param[out] failed_index An optional pointer to receive the index of the first invalid point on a deserialization failure. Can be NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_points_from_bytes(const uint8_t* buffer, size_t buffer_len, size_t n, voprf_format format, voprf_point_t* points, voprf_validation mode, size_t num_threads, size_t* failed_index);
+
+/**
+ * @brief Serializes `n` points back to back into one buffer.
+ *
+ * Points are converted to affine form in blocks that share a single field
+ * inversion, rather than one inversion per point as in
+ * `voprf_point_to_bytes`, and the work is spread over `num_threads` worker
+ * threads. The output is untagged: point `i` occupies bytes
+ * `[i * size, (i + 1) * size)`, where `size` is `VOPRF_POINT_BYTES` for the
+ * compressed format and `VOPRF_POINT_UNCOMPRESSED_BYTES` otherwise.
+ *
+ * @param[in] points The points to serialize, `n` entries.
+ * @param[in] n The number of points.
+ * @param[in] format The encoding to use.
+ * @param[out] buffer The buffer to write the points into.
+ * @param[in] buffer_len The size of the buffer; at least `n * size`.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_points_to_bytes(const voprf_point_t* const* points, size_t n, voprf_format format, uint8_t* buffer, size_t buffer_len, size_t num_threads);
+
+//----------------------------------------------------------------
+// Blinding Factor Pool
+//----------------------------------------------------------------
+//
+// A client-side pool of precomputed blinding factors and their inverses.
+// Blinding through the pool skips keygen, and unblinding skips the field
+// inversion, so the online cost is hash-to-point plus two scalar
+// multiplications. Pooled blinding returns an *unblinding* factor (the
+// inverse of the blinding factor), which must be passed to
+// `voprf_unblind_pooled`, never to `voprf_unblind`. A pool may be shared
+// between threads.
+
+/**
+ * @brief Creates a blinding factor pool.
+ *
+ * @param[in] capacity The maximum number of precomputed factors to hold.
+ * @param[in] background If true, a background thread keeps the pool topped
+ *            up whenever it drains below half its capacity.
+ * @param[out] pool A pointer to receive the newly created pool.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_blind_pool_create(size_t capacity, bool background, voprf_blind_pool_t** pool);
+
+/**
+ * @brief Destroys a pool, stopping its background thread if any.
+ *
+ * @param pool The pool to destroy. Can be NULL.
+ */
+void voprf_blind_pool_destroy(voprf_blind_pool_t* pool);
+
+/**
+ * @brief Fills the pool up to its capacity on the calling thread.
+ *
+ * @param[in] pool The pool to fill.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_blind_pool_fill(voprf_blind_pool_t* pool);
+
+/**
+ * @brief Gets the number of precomputed factors currently in the pool.
+ *
+ * @param[in] pool The pool.
+ * @param[out] size A pointer to store the number of available factors.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_blind_pool_size(const voprf_blind_pool_t* pool, size_t* size);
+
+/**
+ * @brief Hashes and blinds a message using a factor from the pool.
+ *
+ * If the pool is empty, a factor is computed inline.
+ *
+ * @param[in] pool The pool to draw from.
+ * @param[in] msg The input message buffer.
+ * @param[in] msg_len The length of the input message.
+ * @param[out] unblinding_factor A pointer to receive the unblinding factor.
+ * @param[out] blinded_point A pointer to receive the resulting blinded point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_blind_pooled(voprf_blind_pool_t* pool, const uint8_t* msg, size_t msg_len, voprf_private_key_t** unblinding_factor, voprf_point_t** blinded_point);
+
+/**
+ * @brief Hashes and blinds a message using a factor from the pool, into existing objects.
+ *
+ * @param[in] pool The pool to draw from.
+ * @param[in] msg The input message buffer.
+ * @param[in] msg_len The length of the input message.
+ * @param[out] unblinding_factor The object to receive the unblinding factor.
+ * @param[out] blinded_point The object to receive the blinded point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_blind_pooled_into(voprf_blind_pool_t* pool, const uint8_t* msg, size_t msg_len, voprf_private_key_t* unblinding_factor, voprf_point_t* blinded_point);
+
+/**
+ * @brief Unblinds an evaluated point with an unblinding factor from `voprf_blind_pooled`.
+ *
+ * @param[in] evaluated_point The point received from the server.
+ * @param[in] unblinding_factor The unblinding factor from `voprf_blind_pooled`.
+ * @param[out] final_output A pointer to receive the final OPRF output point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_unblind_pooled(const voprf_point_t* evaluated_point, const voprf_private_key_t* unblinding_factor, voprf_point_t** final_output);
+
+/**
+ * @brief Unblinds an evaluated point with a pooled unblinding factor, into an existing object.
+ *
+ * @param[in] evaluated_point The point received from the server.
+ * @param[in] unblinding_factor The unblinding factor from `voprf_blind_pooled`.
+ * @param[out] final_output The object to receive the final OPRF output.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_unblind_pooled_into(const voprf_point_t* evaluated_point, const voprf_private_key_t* unblinding_factor, voprf_point_t* final_output);
+
+//----------------------------------------------------------------
+// Hash-to-Point Cache
+//----------------------------------------------------------------
+//
+// A bounded, thread-safe LRU cache of the curve points that input messages
+// hash to, for verifiers that see the same messages repeatedly. Entries are
+// keyed by a digest of the message, so a hit still hashes the message but
+// skips the expensive map onto the curve. A cache may be shared between
+// threads and between keys.
+
+/**
+ * @brief Creates a hash-to-point cache.
+ *
+ * @param[in] capacity The maximum number of cached points. Memory use is
+ *            bounded by a small constant times this number.
+ * @param[out] cache A pointer to receive the newly created cache.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_hash_cache_create(size_t capacity, voprf_hash_cache_t** cache);
+
+/**
+ * @brief Destroys a cache and frees its memory.
+ *
+ * @param cache The cache to destroy. Can be NULL.
+ */
+void voprf_hash_cache_destroy(voprf_hash_cache_t* cache);
+
+/**
+ * @brief Gets the cache's hit and miss counts and current size.
+ *
+ * @param[in] cache The cache.
+ * @param[out] hits A pointer to store the number of hits. Can be NULL.
+ * @param[out] misses A pointer to store the number of misses. Can be NULL.
+ * @param[out] size A pointer to store the number of cached points. Can be NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_hash_cache_get_stats(voprf_hash_cache_t* cache, uint64_t* hits, uint64_t* misses, size_t* size);
+
+/**
+ * @brief Verifies an OPRF output, looking up the hashed input in a cache.
+ *
+ * Behaves like `voprf_verify`.
+ *
+ * @param[in] pk The server's public key.
+ * @param[in] cache The hash-to-point cache to consult and update.
+ * @param[in] input_msg The original input message.
+ * @param[in] input_msg_len The length of the input message.
+ * @param[in] output_point The final OPRF output point to verify.
+ * @param[out] result A pointer to store the boolean verification result.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verify_cached(const voprf_public_key_t* pk, voprf_hash_cache_t* cache, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result);
+
+/**
+ * @brief Verifies an OPRF output using a prepared verifier and a hash-to-point cache.
+ *
+ * Behaves like `voprf_verifier_verify`.
+ *
+ * @param[in] verifier The prepared verifier.
+ * @param[in] cache The hash-to-point cache to consult and update.
+ * @param[in] input_msg The original input message.
+ * @param[in] input_msg_len The length of the input message.
+ * @param[in] output_point The final OPRF output point to verify.
+ * @param[out] result A pointer to store the boolean verification result.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verifier_verify_cached(const voprf_verifier_t* verifier, voprf_hash_cache_t* cache, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result);
+
+//----------------------------------------------------------------
+// Verifiable Evaluation
+//----------------------------------------------------------------
+//
+// A pairing-free alternative to `voprf_verify`. Alongside its regular public
+// key, a private key `k` has a *proof key* `G * k`, a point on the same
+// curve as the blinded points. The server can attach a DLEQ (Chaum-Pedersen)
+// proof to an evaluation showing that it used the key behind the proof key.
+// The client checks the proof on the blinded and evaluated points before
+// unblinding, with two small multi-scalar multiplications and no pairings.
+
+/**
+ * @brief Derives the proof key of a private key.
+ *
+ * @param[in] private_key The private key.
+ * @param[out] proof_key A pointer to receive the newly created proof key point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_private_key_get_proof_key(const voprf_private_key_t* private_key, voprf_point_t** proof_key);
+
+/**
+ * @brief Gets the proof key of a prepared server context.
+ *
+ * The proof key is computed once when the context is created.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[out] proof_key A pointer to receive the newly created proof key point.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_get_proof_key(const voprf_server_ctx_t* ctx, voprf_point_t** proof_key);
+
+/**
+ * @brief Evaluates a blinded point and proves that `sk` was used.
+ *
+ * Derives the proof key on every call; servers should prefer
+ * `voprf_server_ctx_evaluate_with_proof`.
+ *
+ * @param[in] sk The server's private key.
+ * @param[in] blinded_point The blinded point from the client.
+ * @param[out] evaluated_point A pointer to receive the newly created evaluated point object.
+ * @param[out] proof A buffer to receive the serialized proof.
+ * @param[in] proof_len The size of the proof buffer; at least `VOPRF_PROOF_BYTES`.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_evaluate_with_proof(const voprf_private_key_t* sk, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point, uint8_t* proof, size_t proof_len);
+
+/**
+ * @brief Evaluates a blinded point and proves that the context's key was used.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[in] blinded_point The blinded point from the client.
+ * @param[out] evaluated_point A pointer to receive the newly created evaluated point object.
+ * @param[out] proof A buffer to receive the serialized proof.
+ * @param[in] proof_len The size of the proof buffer; at least `VOPRF_PROOF_BYTES`.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_evaluate_with_proof(const voprf_server_ctx_t* ctx, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point, uint8_t* proof, size_t proof_len);
+
+/**
+ * @brief Checks a proof that an evaluated point was computed with the key behind a proof key.
+ *
+ * @param[in] proof_key The server's proof key.
+ * @param[in] blinded_point The blinded point sent to the server.
+ * @param[in] evaluated_point The evaluated point returned by the server.
+ * @param[in] proof The serialized proof.
+ * @param[in] proof_len The length of the proof.
+ * @param[out] result A pointer to a boolean that will be set to true if the proof is valid, false otherwise.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verify_proof(const voprf_point_t* proof_key, const voprf_point_t* blinded_point, const voprf_point_t* evaluated_point, const uint8_t* proof, size_t proof_len, bool* result);
+
+/**
+ * @brief Evaluates a batch of blinded points with a single proof covering all of them.
+ *
+ * The proof has the same size as a single-point proof, whatever the batch
+ * size. Otherwise behaves as `voprf_server_ctx_evaluate_batch`.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[in] in The blinded points, `n` entries.
+ * @param[in] n The number of points; must be non-zero.
+ * @param[out] out An array of `n` pointers to receive the newly created evaluated point objects.
+ * @param[in] num_threads The number of worker threads to use for the evaluation, or 0 for one per core.
+ * @param[out] proof A buffer to receive the serialized proof.
+ * @param[in] proof_len The size of the proof buffer; at least `VOPRF_PROOF_BYTES`.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_server_ctx_evaluate_batch_with_proof(const voprf_server_ctx_t* ctx, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads, uint8_t* proof, size_t proof_len);
+
+/**
+ * @brief Checks a batch proof from `voprf_server_ctx_evaluate_batch_with_proof`.
+ *
+ * The points must be passed in the order the server evaluated them.
+ *
+ * @param[in] proof_key The server's proof key.
+ * @param[in] blinded_points The blinded points sent to the server, `n` entries.
+ * @param[in] evaluated_points The evaluated points returned by the server, `n` entries.
+ * @param[in] n The number of points; must be non-zero.
+ * @param[in] proof The serialized proof.
+ * @param[in] proof_len The length of the proof.
+ * @param[out] result A pointer to a boolean that will be set to true if the proof is valid, false otherwise.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_verify_proof_batch(const voprf_point_t* proof_key, const voprf_point_t* const* blinded_points, const voprf_point_t* const* evaluated_points, size_t n, const uint8_t* proof, size_t proof_len, bool* result);
+
+//----------------------------------------------------------------
+// Keyring
+//----------------------------------------------------------------
+//
+// A set of server keys for serving several key generations during rotation.
+// Each key is identified by a 64-bit key ID derived from its public key, so
+// clients can tag requests with the ID of the key they expect. Keys are
+// prepared once when added; lookups are O(1) and never wait for a writer,
+// and keys can be added and retired while other threads are evaluating. A
+// retired key stops being found at once; it is wiped and freed by a later
+// add or retire once the calls already using it have returned, or by
+// voprf_keyring_destroy.
+
+/**
+ * @brief Computes the key ID of a public key.
+ *
+ * @param[in] pk The public key.
+ * @param[out] key_id A pointer to receive the key ID.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_public_key_get_id(const voprf_public_key_t* pk, uint64_t* key_id);
+
+/**
+ * @brief Creates an empty keyring.
+ *
+ * @param[out] keyring A pointer to receive the newly created keyring.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_keyring_create(voprf_keyring_t** keyring);
+
+/**
+ * @brief Destroys a keyring and every key it has held.
+ *
+ * No other thread may be using the keyring.
+ *
+ * @param keyring The keyring to destroy. Can be NULL.
+ */
+void voprf_keyring_destroy(voprf_keyring_t* keyring);
+
+/**
+ * @brief Adds a private key to a keyring.
+ *
+ * Adding a key that is already present succeeds without changing anything.
+ *
+ * @param[in] keyring The keyring.
+ * @param[in] sk The private key to add. The keyring keeps its own copy.
+ * @param[out] key_id An optional pointer to receive the key's ID. Can be NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_keyring_add(voprf_keyring_t* keyring, const voprf_private_key_t* sk, uint64_t* key_id);
+
+/**
+ * @brief Retires a key so that later lookups no longer find it.
+ *
+ * Calls already using the key complete normally.
+ *
+ * @param[in] keyring The keyring.
+ * @param[in] key_id The ID of the key to retire.
+ * @return 0 on success, non-zero on failure (including an unknown key ID).
+ */
+int voprf_keyring_retire(voprf_keyring_t* keyring, uint64_t key_id);
+
+/**
+ * @brief Gets the number of keys currently in a keyring.
+ *
+ * @param[in] keyring The keyring.
+ * @param[out] size A pointer to receive the number of keys.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_keyring_size(const voprf_keyring_t* keyring, size_t* size);
+
+/**
+ * @brief Gets the public key for a key ID.
+ *
+ * @param[in] keyring The keyring.
+ * @param[in] key_id The key ID.
+ * @param[out] public_key A pointer to receive the newly created public key object.
+ * @return 0 on success, non-zero on failure (including an unknown key ID).
+ */
+int voprf_keyring_get_public_key(const voprf_keyring_t* keyring, uint64_t key_id, voprf_public_key_t** public_key);
+
+/**
+ * @brief Evaluates a blinded point with the key identified by key_id.
+ *
+ * @param[in] keyring The keyring.
+ * @param[in] key_id The ID of the key to evaluate with.
+ * @param[in] blinded_point The blinded point from the client.
+ * @param[out] evaluated_point A pointer to receive the newly created evaluated point object.
+ * @return 0 on success, non-zero on failure (including an unknown key ID).
+ */
+int voprf_keyring_evaluate(const voprf_keyring_t* keyring, uint64_t key_id, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point);
+
+/**
+ * @brief As `voprf_keyring_evaluate`, writing into an existing point object.
+ *
+ * @return 0 on success, non-zero on failure (including an unknown key ID).
+ */
+int voprf_keyring_evaluate_into(const voprf_keyring_t* keyring, uint64_t key_id, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point);
+
+/**
+ * @brief Evaluates a batch of blinded points with the key identified by key_id.
+ *
+ * The key is looked up once for the whole batch. Otherwise behaves as
+ * `voprf_server_ctx_evaluate_batch`.
+ *
+ * @param[in] keyring The keyring.
+ * @param[in] key_id The ID of the key to evaluate with.
+ * @param[in] in The blinded points, `n` entries.
+ * @param[in] n The number of points.
+ * @param[out] out An array of `n` pointers to receive the newly created evaluated point objects.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure (including an unknown key ID).
+ */
+int voprf_keyring_evaluate_batch(const voprf_keyring_t* keyring, uint64_t key_id, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads);
+
+/**
+ * @brief Verifies an output against the key identified by key_id.
+ *
+ * Uses the key's precomputed pairing lines, as `voprf_verifier_verify` does.
+ *
+ * @param[in] keyring The keyring.
+ * @param[in] key_id The ID of the key to verify against.
+ * @param[in] input_msg The original input message.
+ * @param[in] input_msg_len The length of the input message.
+ * @param[in] output_point The final output point to verify.
+ * @param[out] result A pointer to a boolean that will be set to true if valid, false otherwise.
+ * @return 0 on success, non-zero on failure (including an unknown key ID).
+ */
+int voprf_keyring_verify(const voprf_keyring_t* keyring, uint64_t key_id, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result);
+
+//----------------------------------------------------------------
+// Key Store
+//----------------------------------------------------------------
+//
+// A file of per-tenant keys for servers holding one key per tenant. The file
+// holds fixed-size records sorted by a 64-bit tenant ID and is opened with
+// mmap, so opening takes constant time regardless of the number of tenants.
+// A tenant's keys are read from the mapping when first used, and prepared
+// contexts for recently used tenants are kept in a bounded LRU cache. A
+// store may be shared between threads. Only available on POSIX systems.
+
+/**
+ * @brief Writes a key store file.
+ *
+ * Public keys are derived and stored alongside the private keys, so readers
+ * never have to recompute them. The file is readable by its owner only. It
+ * is written under a temporary name, synced, then renamed over `path`. A
+ * store that is already open keeps serving the old keys, and a failed write
+ * leaves any existing file as it was.
+ *
+ * @param[in] path The path of the file to create or replace.
+ * @param[in] tenant_ids The tenant IDs, `n` entries. They must be distinct.
+ * @param[in] keys The private keys, `n` entries; `keys[i]` belongs to `tenant_ids[i]`.
+ * @param[in] n The number of tenants.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_key_store_write(const char* path, const uint64_t* tenant_ids, const voprf_private_key_t* const* keys, size_t n, size_t num_threads);
+
+/**
+ * @brief Opens a key store file.
+ *
+ * Only the file header is read.
+ *
+ * @param[in] path The path of the key store file.
+ * @param[in] cache_capacity The maximum number of prepared tenant contexts to cache, or 0 for none.
+ * @param[out] store A pointer to receive the newly opened store.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_key_store_open(const char* path, size_t cache_capacity, voprf_key_store_t** store);
+
+/**
+ * @brief Closes a key store and unmaps its file.
+ *
+ * @param store The store to close. Can be NULL.
+ */
+void voprf_key_store_close(voprf_key_store_t* store);
+
+/**
+ * @brief Gets the number of tenants in a key store.
+ *
+ * @param[in] store The key store.
+ * @param[out] size A pointer to receive the number of tenants.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_key_store_size(const voprf_key_store_t* store, size_t* size);
+
+/**
+ * @brief Reads a tenant's private key from a key store.
+ *
+ * @param[in] store The key store.
+ * @param[in] tenant_id The tenant ID.
+ * @param[out] key A pointer to receive the newly created private key object.
+ * @return 0 on success, non-zero on failure (including an unknown tenant ID).
+ */
+int voprf_key_store_get_private_key(const voprf_key_store_t* store, uint64_t tenant_id, voprf_private_key_t** key);
+
+/**
+ * @brief Reads a tenant's public key from a key store.
+ *
+ * @param[in] store The key store.
+ * @param[in] tenant_id The tenant ID.
+ * @param[out] key A pointer to receive the newly created public key object.
+ * @return 0 on success, non-zero on failure (including an unknown tenant ID).
+ */
+int voprf_key_store_get_public_key(const voprf_key_store_t* store, uint64_t tenant_id, voprf_public_key_t** key);
+
+/**
+ * @brief Evaluates a blinded point with a tenant's key.
+ *
+ * @param[in] store The key store.
+ * @param[in] tenant_id The tenant ID.
+ * @param[in] blinded_point The blinded point from the client.
+ * @param[out] evaluated_point A pointer to receive the newly created evaluated point object.
+ * @return 0 on success, non-zero on failure (including an unknown tenant ID).
+ */
+int voprf_key_store_evaluate(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point);
+
+/**
+ * @brief As `voprf_key_store_evaluate`, writing into an existing point object.
+ *
+ * @return 0 on success, non-zero on failure (including an unknown tenant ID).
+ */
+int voprf_key_store_evaluate_into(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point);
+
+/**
+ * @brief Evaluates a batch of blinded points with a tenant's key.
+ *
+ * The tenant is looked up once for the whole batch. Otherwise behaves as
+ * `voprf_server_ctx_evaluate_batch`.
+ *
+ * @param[in] store The key store.
+ * @param[in] tenant_id The tenant ID.
+ * @param[in] in The blinded points, `n` entries.
+ * @param[in] n The number of points.
+ * @param[out] out An array of `n` pointers to receive the newly created evaluated point objects.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @return 0 on success, non-zero on failure (including an unknown tenant ID).
+ */
+int voprf_key_store_evaluate_batch(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads);
+
+/**
+ * @brief Verifies an output against a tenant's public key.
+ *
+ * The tenant's pairing precomputation is done on its first verification
+ * and cached with its context.
+ *
+ * @param[in] store The key store.
+ * @param[in] tenant_id The tenant ID.
+ * @param[in] input_msg The original input message.
+ * @param[in] input_msg_len The length of the input message.
+ * @param[in] output_point The final output point to verify.
+ * @param[out] result A pointer to a boolean that will be set to true if valid, false otherwise.
+ * @return 0 on success, non-zero on failure (including an unknown tenant ID).
+ */
+int voprf_key_store_verify(voprf_key_store_t* store, uint64_t tenant_id, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result);
+
+/**
+ * @brief Reads a key store's context cache counters.
+ *
+ * @param[in] store The key store.
+ * @param[out] hits A pointer to receive the number of cache hits. Can be NULL.
+ * @param[out] misses A pointer to receive the number of cache misses. Can be NULL.
+ * @param[out] size A pointer to receive the number of cached contexts. Can be NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_key_store_get_cache_stats(voprf_key_store_t* store, uint64_t* hits, uint64_t* misses, size_t* size);
+
+//----------------------------------------------------------------
+// Bulk Evaluation
+//----------------------------------------------------------------
+
+/** @brief Throughput report for `voprf_evaluate_file`. */
+typedef struct voprf_bulk_stats_t {
+    /** The number of records evaluated. */
+    uint64_t records;
+    /** The wall-clock time taken, in seconds. */
+    double seconds;
+    /** The number of records evaluated per second. */
+    double records_per_sec;
+    /** On a deserialization failure, the index of the first malformed record. */
+    uint64_t failed_record;
+} voprf_bulk_stats_t;
+
+/**
+ * @brief Evaluates every blinded point in a file and writes the results to another file.
+ *
+ * The input is a flat sequence of `VOPRF_POINT_BYTES`-sized serialized
+ * points, as produced by `voprf_point_to_bytes`. It is memory-mapped and
+ * processed in chunks of `chunk_records` records spread over `num_threads`
+ * worker threads; each chunk is written out while the next one is being
+ * evaluated. The output file has the same layout, with record `i` holding
+ * the evaluation of input record `i`. Memory use is bounded by two chunks of
+ * output regardless of the file size. The output is written to a temporary
+ * file next to `output_path` and renamed over it only on success, so on
+ * failure `output_path` is left as it was. Only available on POSIX systems.
+ *
+ * @param[in] ctx The prepared server context.
+ * @param[in] input_path The path of the file of blinded points.
+ * @param[in] output_path The path of the file to create or overwrite.
+ * @param[in] chunk_records The number of records per chunk, or 0 for a default.
+ * @param[in] num_threads The number of worker threads to use, or 0 for one per core.
+ * @param[out] stats An optional pointer to receive a throughput report. Can be NULL.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_evaluate_file(const voprf_server_ctx_t* ctx, const char* input_path, const char* output_path, size_t chunk_records, size_t num_threads, voprf_bulk_stats_t* stats);
+
+//----------------------------------------------------------------
+// Asynchronous Engine
+//----------------------------------------------------------------
+//
+// An engine owns a work-stealing pool of worker threads and runs blind,
+// evaluate, unblind and verify jobs off the caller's thread. A job covers
+// `n` items. It is split into ranges that idle workers steal from one
+// another, and it completes once all of its items are done. There are two
+// ways to learn that a job has completed:
+//
+// - A callback, if the job sets one. It runs on a worker thread.
+// - Otherwise, a completion record that is collected with
+//   `voprf_engine_poll`. On Linux, `voprf_engine_get_fd` gives an eventfd
+//   that is readable while records are waiting.
+//
+// Every array and object a job refers to must stay valid until the job
+// completes.
+
+/** @brief The operation performed by a job. */
+typedef enum voprf_job_type {
+    /** Hash and blind `msgs` into `out_points`, writing the factors to `factors`. */
+    VOPRF_JOB_BLIND = 0,
+    /** Evaluate `points` under `ctx` into `out_points`. */
+    VOPRF_JOB_EVALUATE = 1,
+    /** Unblind `points` with `factors` into `out_points`. */
+    VOPRF_JOB_UNBLIND = 2,
+    /** Check the outputs in `points` against `msgs` with `verifier` into `results`. */
+    VOPRF_JOB_VERIFY = 3,
+} voprf_job_type;
+
+/**
+ * @brief Called on a worker thread when a job completes.
+ *
+ * The callback must not destroy the engine. It must not call
+ * `voprf_engine_submit`, because that can wait for room that only the
+ * workers can free. It may call `voprf_engine_try_submit`.
+ *
+ * @param user_data The job's `user_data`.
+ * @param job_id The ID returned when the job was submitted.
+ * @param status 0 if every item succeeded, otherwise the first failure.
+ */
+typedef void (*voprf_job_callback)(void* user_data, uint64_t job_id, int status);
+
+/**
+ * @brief A job description.
+ *
+ * Only the fields that the job type uses are read. Each array holds `n`
+ * entries, and entry `i` of every array belongs to item `i`.
+ */
+typedef struct voprf_job_t {
+    /** The operation to perform. */
+    voprf_job_type type;
+    /** The number of items. Must be at least 1. */
+    size_t n;
+    /** BLIND, VERIFY: the input messages. */
+    const uint8_t* const* msgs;
+    /** BLIND, VERIFY: the message lengths. */
+    const size_t* msg_lens;
+    /** EVALUATE: the prepared server context. */
+    const voprf_server_ctx_t* ctx;
+    /** VERIFY: the prepared verifier. */
+    const voprf_verifier_t* verifier;
+    /** EVALUATE: the blinded points. UNBLIND: the evaluated points. VERIFY: the outputs to check. */
+    const voprf_point_t* const* points;
+    /** BLIND: objects that receive the blinding factors. UNBLIND: the blinding factors. */
+    voprf_private_key_t* const* factors;
+    /** BLIND: blinded points. EVALUATE: evaluated points. UNBLIND: final outputs. */
+    voprf_point_t* const* out_points;
+    /** VERIFY: receives the result of each check. */
+    bool* results;
+    /** Called on completion. Can be NULL to get a completion record instead. */
+    voprf_job_callback callback;
+    /** Passed back with the completion. */
+    void* user_data;
+} voprf_job_t;
+
+/** @brief A completion record for a job submitted without a callback. */
+typedef struct voprf_job_completion_t {
+    /** The ID returned when the job was submitted. */
+    uint64_t job_id;
+    /** 0 if every item succeeded, otherwise the first failure. */
+    int status;
+    /** The job's `user_data`. */
+    void* user_data;
+} voprf_job_completion_t;
+
+/**
+ * @brief Creates an engine.
+ *
+ * @param[in] num_threads The number of worker threads, or 0 for one per core.
+ * @param[in] max_pending The maximum number of submitted items that have not
+ *            yet completed, or 0 for no limit. A job with more items than
+ *            this is still admitted when the engine is otherwise empty.
+ * @param[out] engine A pointer to receive the new engine.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_engine_create(size_t num_threads, size_t max_pending, voprf_engine_t** engine);
+
+/**
+ * @brief Waits for every submitted job to complete, then destroys the engine.
+ *
+ * No job may be submitted concurrently with or after this call. Completion
+ * records that were never polled are discarded.
+ *
+ * @param engine The engine to destroy. Can be NULL.
+ */
+void voprf_engine_destroy(voprf_engine_t* engine);
+
+/**
+ * @brief Submits a job, waiting while the engine is at its `max_pending` limit.
+ *
+ * The job description is copied, so it does not need to outlive the call.
+ * The arrays it points to do. The completion can arrive before this function
+ * returns.
+ *
+ * @param[in] engine The engine.
+ * @param[in] job The job to run.
+ * @param[out] job_id A pointer to receive the job's ID.
+ * @return 0 if the job was queued, non-zero on failure.
+ */
+int voprf_engine_submit(voprf_engine_t* engine, const voprf_job_t* job, uint64_t* job_id);
+
+/**
+ * @brief Submits a job if the engine has room for it.
+ *
+ * Behaves like `voprf_engine_submit`, but does not wait. If the job would
+ * exceed the `max_pending` limit, it is not queued and `*accepted` is set to
+ * false.
+ *
+ * @param[in] engine The engine.
+ * @param[in] job The job to run.
+ * @param[out] job_id A pointer to receive the job's ID if it was accepted.
+ * @param[out] accepted A pointer to a boolean set to whether the job was queued.
+ * @return 0 on success (accepted or not), non-zero on failure.
+ */
+int voprf_engine_try_submit(voprf_engine_t* engine, const voprf_job_t* job, uint64_t* job_id, bool* accepted);
+
+/**
+ * @brief Collects completion records for jobs submitted without a callback.
+ *
+ * Records are returned in the order the jobs completed.
+ *
+ * @param[in] engine The engine.
+ * @param[out] completions An array of at least `max` records.
+ * @param[in] max The maximum number of records to collect.
+ * @param[out] count A pointer to receive the number of records collected.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_engine_poll(voprf_engine_t* engine, voprf_job_completion_t* completions, size_t max, size_t* count);
+
+/**
+ * @brief Gets a file descriptor that is readable while completion records are waiting.
+ *
+ * The descriptor belongs to the engine. Register it for reading with
+ * poll/epoll, and call `voprf_engine_poll` when it becomes readable.
+ * Reading from it directly is not allowed. Only available on Linux.
+ *
+ * @param[in] engine The engine.
+ * @param[out] fd A pointer to receive the descriptor.
+ * @return 0 on success, non-zero on failure or if unsupported.
+ */
+int voprf_engine_get_fd(const voprf_engine_t* engine, int* fd);
+
+/**
+ * @brief Gets the number of submitted items that have not yet completed.
+ *
+ * @param[in] engine The engine.
+ * @param[out] pending A pointer to receive the queue depth, in items.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_engine_pending(const voprf_engine_t* engine, size_t* pending);
+
+/**
+ * @brief Gets the number of worker threads in the engine.
+ *
+ * @param[in] engine The engine.
+ * @param[out] num_threads A pointer to receive the thread count.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_engine_num_threads(const voprf_engine_t* engine, size_t* num_threads);
+
+//----------------------------------------------------------------
+// Statistics
+//----------------------------------------------------------------
+//
+// Counters and latency histograms for the library's hot paths. Recording is
+// compiled in only when the library is built with VOPRF_ENABLE_STATS;
+// otherwise `voprf_stats_snapshot` reports `enabled == false` and all zeros.
+
+/** @brief The number of log2 latency buckets per operation. */
+#define VOPRF_STATS_LATENCY_BUCKETS 32
+
+/** @brief The number of error counters; `errors[i]` counts status `-i`. */
+#define VOPRF_STATS_ERROR_CODES 32
+
+/**
+ * @brief The operations for which calls and latency are recorded.
+ *
+ * The `_BATCH` operations count one call per batch, with the latency of the
+ * whole batch, so they are kept apart from their single-item counterparts.
+ */
+typedef enum voprf_stats_op {
+    VOPRF_STATS_OP_BLIND = 0,
+    VOPRF_STATS_OP_BLIND_BATCH,
+    VOPRF_STATS_OP_EVALUATE,
+    VOPRF_STATS_OP_EVALUATE_BATCH,
+    VOPRF_STATS_OP_UNBLIND,
+    VOPRF_STATS_OP_UNBLIND_BATCH,
+    VOPRF_STATS_OP_VERIFY,
+    VOPRF_STATS_OP_VERIFY_BATCH,
+    VOPRF_STATS_OP_HASH_TO_POINT,
+    VOPRF_STATS_OP_SERIALIZE,
+    VOPRF_STATS_OP_DESERIALIZE,
+    VOPRF_STATS_OP_COUNT
+} voprf_stats_op;
+
+/** @brief Call count and latency histogram for one operation. */
+typedef struct voprf_stats_op_t {
+    /** The number of completed calls, successful or not. */
+    uint64_t calls;
+    /** The sum of all call latencies in nanoseconds. */
+    uint64_t total_ns;
+    /** Bucket `b` counts calls that took [2^b, 2^(b+1)) ns; the last bucket is open-ended. */
+    uint64_t latency_buckets[VOPRF_STATS_LATENCY_BUCKETS];
+} voprf_stats_op_t;
+
+/** @brief A point-in-time copy of the library's counters. */
+typedef struct voprf_stats_t {
+    /** Whether the library was built with statistics support. */
+    bool enabled;
+    /** Per-operation counters, indexed by `voprf_stats_op`. */
+    voprf_stats_op_t ops[VOPRF_STATS_OP_COUNT];
+    /** Error counts by status code; `errors[i]` counts status `-i`, the last entry also counts lower codes. */
+    uint64_t errors[VOPRF_STATS_ERROR_CODES];
+    /** Total bytes written by the serialization functions. */
+    uint64_t bytes_serialized;
+    /** Total bytes consumed by the deserialization functions. */
+    uint64_t bytes_deserialized;
+} voprf_stats_t;
+
+/**
+ * @brief Takes a snapshot of the library's counters since startup.
+ *
+ * Counters only ever increase; compute rates from the difference between
+ * two snapshots. Safe to call from any thread.
+ *
+ * @param[out] stats The structure to fill.
+ * @return 0 on success, non-zero on failure.
+ */
+int voprf_stats_snapshot(voprf_stats_t* stats);
 
 #ifdef __cplusplus
 }
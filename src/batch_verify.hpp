@@ -0,0 +1,89 @@
+#ifndef VOPRF_BATCH_VERIFY_HPP
+#define VOPRF_BATCH_VERIFY_HPP
+
+#include "base.hpp"
+#include "elements.hpp"
+
+#include <algorithm>
+
+namespace voprf {
+    // Verifies many (H(m_i), out_i) pairs against one key at once. With random
+    // coefficients r_i the N checks e(H(m_i), pk) == e(out_i, g2) fold into
+    //
+    //     e(sum r_i H(m_i), pk) == e(sum r_i out_i, g2)
+    //
+    // which costs two multi-scalar multiplications and one pairing check. A
+    // forged entry passes only if it cancels under the random r_i, which
+    // happens with probability about 2^-COEFF_BITS.
+    class BatchVerifier {
+        static constexpr size_t COEFF_BITS = 128;
+
+        public:
+            BatchVerifier(const PreparedVerificationKey& pk, vector<mcl::bn::G1> hashed, vector<mcl::bn::G1> outputs)
+                : pk(pk), hashed(std::move(hashed)), outputs(std::move(outputs)) {
+                coeffs.resize(this->hashed.size());
+                for (auto& c : coeffs) {
+                    c = RandomCoefficient();
+                }
+            }
+
+            // Returns true when every pair verifies. If results is non-null it
+            // receives a per-entry verdict; when the combined check fails the
+            // batch is bisected to find the failing entries.
+            bool Run(bool* results) {
+                size_t n = hashed.size();
+                if (n == 0) {
+                    return true;
+                }
+                if (results == nullptr) {
+                    return CheckRange(0, n);
+                }
+                return Bisect(0, n, results, false);
+            }
+        private:
+            static mcl::bn::Fr RandomCoefficient() {
+                mcl::bn::Fr r;
+                r.setRand();
+                mcl::fp::Block b;
+                r.getBlock(b);
+                mcl::bn::Fr c;
+                c.setArrayMask(b.p, std::min(b.n, COEFF_BITS / mcl::fp::UnitBitSize));
+                return c;
+            }
+
+            bool CheckRange(size_t begin, size_t end) {
+                if (end - begin == 1) {
+                    return Pairing::Check(Point(hashed[begin]), pk, Point(outputs[begin]));
+                }
+                mcl::bn::G1 x;
+                mcl::bn::G1 y;
+                mcl::bn::G1::mulVec(x, &hashed[begin], &coeffs[begin], end - begin);
+                mcl::bn::G1::mulVec(y, &outputs[begin], &coeffs[begin], end - begin);
+                return Pairing::Check(Point(x), pk, Point(y));
+            }
+
+            // known_bad is set when the sibling half passed, which means this
+            // half must contain a failure and its combined check can be skipped.
+            bool Bisect(size_t begin, size_t end, bool* results, bool known_bad) {
+                if (!known_bad && CheckRange(begin, end)) {
+                    std::fill(results + begin, results + end, true);
+                    return true;
+                }
+                if (end - begin == 1) {
+                    results[begin] = false;
+                    return false;
+                }
+                size_t mid = begin + (end - begin) / 2;
+                bool left_ok = Bisect(begin, mid, results, false);
+                Bisect(mid, end, results, left_ok);
+                return false;
+            }
+
+            const PreparedVerificationKey& pk;
+            vector<mcl::bn::G1> hashed;
+            vector<mcl::bn::G1> outputs;
+            vector<mcl::bn::Fr> coeffs;
+    };
+}
+
+#endif // VOPRF_BATCH_VERIFY_HPP
@@ -0,0 +1,148 @@
+#ifndef VOPRF_BLIND_POOL_HPP
+#define VOPRF_BLIND_POOL_HPP
+
+#include "base.hpp"
+#include "elements.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace voprf {
+    // A blinding factor together with its inverse, so that neither keygen
+    // nor the inversion has to happen on the online path.
+    struct BlindingPair {
+        SecretKey r;
+        SecretKey r_inv;
+    };
+
+    // A bounded pool of precomputed blinding pairs. Pairs are produced in
+    // chunks whose inverses share one field inversion. The pool can be filled
+    // explicitly with Fill(), or kept topped up by a background thread that
+    // wakes whenever the pool drains below half its capacity.
+    class BlindPool {
+        static constexpr size_t CHUNK_SIZE = 64;
+
+        public:
+            BlindPool(size_t capacity, bool background): capacity(std::max<size_t>(capacity, 1)) {
+                pairs.reserve(this->capacity);
+                if (background) {
+                    worker = std::thread([this] { Run(); });
+                }
+            }
+
+            ~BlindPool() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                cv.notify_all();
+                if (worker.joinable()) {
+                    worker.join();
+                }
+            }
+
+            BlindPool(const BlindPool&) = delete;
+            BlindPool& operator=(const BlindPool&) = delete;
+
+            // Tops the pool up to capacity on the calling thread.
+            void Fill() {
+                while (true) {
+                    size_t want;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        want = std::min(capacity - pairs.size(), CHUNK_SIZE);
+                    }
+                    if (want == 0) {
+                        return;
+                    }
+                    Push(Generate(want));
+                }
+            }
+
+            // Takes one pair from the pool, or computes a fresh one inline if
+            // the pool is empty.
+            BlindingPair Take() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!pairs.empty()) {
+                        BlindingPair pair = pairs.back();
+                        pairs.pop_back();
+                        if (pairs.size() < capacity / 2) {
+                            cv.notify_one();
+                        }
+                        return pair;
+                    }
+                }
+                cv.notify_one();
+                SecretKey r = SecretKey::Keygen();
+                return BlindingPair{r, r.Inverse()};
+            }
+
+            size_t Size() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                return pairs.size();
+            }
+        private:
+            static vector<BlindingPair> Generate(size_t n) {
+                vector<mcl::bn::Fr> inv(n);
+                vector<BlindingPair> out(n);
+                for (size_t i = 0; i < n; i++) {
+                    do {
+                        out[i].r = SecretKey::Keygen();
+                        inv[i] = out[i].r.GetFr();
+                    } while (inv[i].isZero());
+                }
+                SecretKey::InverseBatch(inv);
+                for (size_t i = 0; i < n; i++) {
+                    out[i].r_inv = SecretKey(inv[i]);
+                }
+                return out;
+            }
+
+            void Push(const vector<BlindingPair>& fresh) {
+                std::lock_guard<std::mutex> lock(mutex);
+                Insert(fresh);
+            }
+
+            // Requires the mutex to be held.
+            void Insert(const vector<BlindingPair>& fresh) {
+                size_t room = capacity - pairs.size();
+                pairs.insert(pairs.end(), fresh.begin(), fresh.begin() + std::min(room, fresh.size()));
+            }
+
+            void Run() {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    cv.wait(lock, [this] { return stopping || pairs.size() < capacity / 2 || pairs.empty(); });
+                    if (stopping) {
+                        return;
+                    }
+                    while (!stopping && pairs.size() < capacity) {
+                        size_t want = std::min(capacity - pairs.size(), CHUNK_SIZE);
+                        lock.unlock();
+                        vector<BlindingPair> fresh;
+                        try {
+                            fresh = Generate(want);
+                        } catch (...) {
+                            // Stop refilling; Take() falls back to computing
+                            // pairs inline.
+                            return;
+                        }
+                        lock.lock();
+                        Insert(fresh);
+                    }
+                }
+            }
+
+            const size_t capacity;
+            mutable std::mutex mutex;
+            std::condition_variable cv;
+            vector<BlindingPair> pairs;
+            bool stopping = false;
+            std::thread worker;
+    };
+}
+
+#endif // VOPRF_BLIND_POOL_HPP
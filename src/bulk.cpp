@@ -0,0 +1,140 @@
+#include "voprf/voprf.h"
+
+#include "capi.hpp"
+#include "elements.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "replacement_file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <vector>
+
+//----------------------------------------------------------------
+// Bulk Evaluation
+//----------------------------------------------------------------
+
+#ifdef VOPRF_HAVE_MMAP
+
+namespace {
+    const size_t DEFAULT_CHUNK_RECORDS = 1 << 16;
+}
+
+extern "C" int voprf_evaluate_file(const voprf_server_ctx_t* ctx, const char* input_path, const char* output_path, size_t chunk_records, size_t num_threads, voprf_bulk_stats_t* stats) {
+    CHECK_NULL_ARG(ctx);
+    CHECK_NULL_ARG(input_path);
+    CHECK_NULL_ARG(output_path);
+    VOPRF_TRY
+        const size_t record = voprf::Point::BYTE_SIZE;
+        auto start = std::chrono::steady_clock::now();
+        if (chunk_records == 0) {
+            chunk_records = DEFAULT_CHUNK_RECORDS;
+        }
+
+        voprf::MappedFile in(input_path, voprf::MappedFile::SEQUENTIAL);
+        if (!in.ok) {
+            return VOPRF_FAIL(VOPRF_ERROR_IO);
+        }
+        if (in.size % record != 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+        }
+        // Written beside output_path and renamed over it only once every
+        // record is in, so a failed run leaves no partial output behind.
+        voprf::ReplacementFile out(output_path, 0644);
+        if (!out.Ok()) {
+            return VOPRF_FAIL(VOPRF_ERROR_IO);
+        }
+
+        // Two output buffers: one chunk is evaluated while the previous one
+        // is being written, so compute and I/O overlap and memory stays at
+        // two chunks regardless of the file size. The buffers are declared
+        // before the futures so that any in-flight write finishes first on
+        // an early exit.
+        const size_t total = in.size / record;
+        std::vector<uint8_t> buffers[2];
+        buffers[0].resize(std::min(chunk_records, total) * record);
+        buffers[1].resize(buffers[0].size());
+        std::future<bool> pending[2];
+
+        std::atomic<size_t> first_bad(SIZE_MAX);
+        size_t chunk_index = 0;
+        for (size_t begin = 0; begin < total; begin += chunk_records, chunk_index++) {
+            size_t count = std::min(chunk_records, total - begin);
+            size_t slot = chunk_index % 2;
+            if (pending[slot].valid() && !pending[slot].get()) {
+                return VOPRF_FAIL(VOPRF_ERROR_IO);
+            }
+
+            const uint8_t* src = in.data + begin * record;
+            uint8_t* dst = buffers[slot].data();
+            voprf::Parallel::For(count, num_threads, [&](size_t lo, size_t hi) {
+                std::vector<voprf::Point> evaluated(hi - lo);
+                for (size_t i = lo; i < hi; i++) {
+                    voprf::Point p;
+                    if (p.Deserialize(src + i * record, record) != record) {
+                        size_t bad = begin + i;
+                        size_t seen = first_bad.load();
+                        while (bad < seen && !first_bad.compare_exchange_weak(seen, bad)) {
+                        }
+                        return;
+                    }
+                    evaluated[i - lo] = ctx->key.Mul(p);
+                }
+                // Serialize with shared inversions rather than one per record.
+                auto get = [&](size_t i) -> const voprf::Point& {
+                    return evaluated[i];
+                };
+                if (!voprf::Point::SerializeBatch(get, hi - lo, dst + lo * record)) {
+                    throw std::runtime_error("voprf: point serialization failed");
+                }
+            });
+            if (first_bad.load() != SIZE_MAX) {
+                if (stats) {
+                    stats->failed_record = first_bad.load();
+                }
+                return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+            }
+
+            size_t offset = begin * record;
+            size_t len = count * record;
+            pending[slot] = std::async(std::launch::async, [&out, dst, len, offset] {
+                return out.WriteAt(dst, len, offset);
+            });
+            in.Release(offset + len);
+        }
+        for (auto& p : pending) {
+            if (p.valid() && !p.get()) {
+                return VOPRF_FAIL(VOPRF_ERROR_IO);
+            }
+        }
+        if (!out.Commit()) {
+            return VOPRF_FAIL(VOPRF_ERROR_IO);
+        }
+
+        if (stats) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            stats->records = total;
+            stats->seconds = seconds;
+            stats->records_per_sec = seconds > 0 ? static_cast<double>(total) / seconds : 0;
+            stats->failed_record = 0;
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+#else
+
+extern "C" int voprf_evaluate_file(const voprf_server_ctx_t* ctx, const char* input_path, const char* output_path, size_t chunk_records, size_t num_threads, voprf_bulk_stats_t* stats) {
+    (void)ctx;
+    (void)input_path;
+    (void)output_path;
+    (void)chunk_records;
+    (void)num_threads;
+    (void)stats;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+#endif // VOPRF_HAVE_MMAP
@@ -0,0 +1,143 @@
+#ifndef VOPRF_CAPI_HPP
+#define VOPRF_CAPI_HPP
+
+// Internals shared by the translation units that implement the C API:
+// status codes, the definitions behind the opaque handles, and the
+// boundary macros.
+
+#include "voprf/voprf.h"
+
+#include "elements.hpp"
+#include "blind_pool.hpp"
+#include "dleq.hpp"
+#include "engine.hpp"
+#include "hash_cache.hpp"
+#include "keyring.hpp"
+#include "key_store.hpp"
+#include "stats.hpp"
+
+#include <new> // For std::bad_alloc
+#include <cstdint>
+
+//----------------------------------------------------------------
+// Internal Error Codes
+//----------------------------------------------------------------
+enum voprf_error_code {
+    VOPRF_SUCCESS = 0,
+    VOPRF_ERROR_NULL_ARG = -1,
+    VOPRF_ERROR_MALLOC = -2,
+    VOPRF_ERROR_SERIALIZATION = -3,
+    VOPRF_ERROR_DESERIALIZATION = -4,
+    VOPRF_ERROR_INVALID_BUFFER_SIZE = -5,
+    VOPRF_ERROR_BAD_ALIGNMENT = -6,
+    VOPRF_ERROR_INVALID_ARGUMENT = -7,
+    VOPRF_ERROR_IO = -8,
+    VOPRF_ERROR_UNSUPPORTED = -9,
+    VOPRF_ERROR_CPP_EXCEPTION = -10,
+    VOPRF_ERROR_UNKNOWN_KEY = -11,
+};
+
+//----------------------------------------------------------------
+// Opaque Struct Definitions
+//----------------------------------------------------------------
+
+// These structs wrap the C++ objects. The user of the C API
+// only ever sees a pointer to these, never their contents.
+struct voprf_private_key_t {
+    voprf::SecretKey sk;
+};
+
+struct voprf_public_key_t {
+    voprf::VerificationKey pk;
+};
+
+struct voprf_point_t {
+    voprf::Point p;
+};
+
+struct voprf_server_ctx_t {
+    voprf::PreparedKey key;
+    voprf::Point proof_key;
+};
+
+struct voprf_verifier_t {
+    voprf::PreparedVerificationKey pk;
+};
+
+struct voprf_hash_cache_t {
+    voprf::HashCache cache;
+
+    explicit voprf_hash_cache_t(size_t capacity): cache(capacity) {}
+};
+
+struct voprf_keyring_t {
+    voprf::Keyring keyring;
+};
+
+#ifdef VOPRF_HAVE_MMAP
+struct voprf_key_store_t {
+    voprf::KeyStore store;
+
+    voprf_key_store_t(const char* path, size_t capacity): store(path, capacity) {}
+};
+#endif
+
+struct voprf_engine_t {
+    voprf::Engine engine;
+
+    voprf_engine_t(size_t num_threads, size_t max_pending): engine(num_threads, max_pending) {}
+};
+
+struct voprf_blind_pool_t {
+    voprf::BlindPool pool;
+
+    voprf_blind_pool_t(size_t capacity, bool background): pool(capacity, background) {}
+};
+
+static_assert(voprf::SecretKey::BYTE_SIZE == VOPRF_PRIVATE_KEY_BYTES, "private key size mismatch");
+static_assert(voprf::VerificationKey::BYTE_SIZE == VOPRF_PUBLIC_KEY_BYTES, "public key size mismatch");
+static_assert(voprf::Point::BYTE_SIZE == VOPRF_POINT_BYTES, "point size mismatch");
+static_assert(voprf::Proof::BYTE_SIZE == VOPRF_PROOF_BYTES, "proof size mismatch");
+static_assert(voprf::VerificationKey::UNCOMPRESSED_BYTE_SIZE == VOPRF_PUBLIC_KEY_UNCOMPRESSED_BYTES, "uncompressed public key size mismatch");
+static_assert(voprf::Point::UNCOMPRESSED_BYTE_SIZE == VOPRF_POINT_UNCOMPRESSED_BYTES, "uncompressed point size mismatch");
+
+//----------------------------------------------------------------
+// Helper Macros
+//----------------------------------------------------------------
+
+// Macro to safely handle C++ exceptions at the API boundary.
+#define VOPRF_TRY \
+    try {
+
+#define VOPRF_CATCH                                            \
+    } catch (const std::bad_alloc&) {                          \
+        return VOPRF_FAIL(VOPRF_ERROR_MALLOC);                 \
+    } catch (const std::exception&) {                          \
+        return VOPRF_FAIL(VOPRF_ERROR_CPP_EXCEPTION);          \
+    } catch (...) {                                            \
+        return VOPRF_FAIL(VOPRF_ERROR_CPP_EXCEPTION);          \
+    }
+
+// Macro for basic NULL argument checks.
+#define CHECK_NULL_ARG(arg) \
+    if (!(arg)) { return VOPRF_FAIL(VOPRF_ERROR_NULL_ARG); }
+
+// Macro for checking caller-provided storage for n objects of type T.
+#define CHECK_STORAGE(storage, storage_len, n, T)                               \
+    CHECK_NULL_ARG(storage);                                                    \
+    if ((n) == 0 || (n) > SIZE_MAX / sizeof(T) ||                               \
+        (storage_len) < (n) * sizeof(T)) {                                      \
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);                     \
+    }                                                                           \
+    if (reinterpret_cast<uintptr_t>(storage) % alignof(T) != 0) {               \
+        return VOPRF_FAIL(VOPRF_ERROR_BAD_ALIGNMENT);                           \
+    }
+
+//----------------------------------------------------------------
+// Shared Helpers
+//----------------------------------------------------------------
+
+// Defined in voprf.cpp. Arguments other than `key` are checked.
+int evaluate_batch(const voprf::PreparedKey& key, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads);
+
+#endif // VOPRF_CAPI_HPP
@@ -0,0 +1,179 @@
+#ifndef VOPRF_DLEQ_HPP
+#define VOPRF_DLEQ_HPP
+
+#include "base.hpp"
+#include "elements.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace voprf {
+    // A Chaum-Pedersen proof that log_G(Y) == log_M(Z), where G is the fixed
+    // G1 generator, Y = G * k is the server's proof key, M is a blinded point
+    // and Z = M * k its evaluation. This follows the DLEQ construction of
+    // RFC 9497 over G1 of the selected group (see group.hpp): checking a
+    // proof costs two 2-term multi-scalar multiplications instead of the
+    // pairings that Pairing::Check needs.
+    //
+    // A batch of pairs (M_i, Z_i) is covered by one proof on the composites
+    // M = sum(d_i * M_i) and Z = sum(d_i * Z_i), where the d_i are derived by
+    // hashing the whole batch (RFC 9497 ComputeComposites). Building the
+    // composites is one multi-scalar multiplication per side, so the proof
+    // stays constant-size and its cost grows far slower than n proofs.
+    class Proof {
+        public:
+            // Serialized size: the challenge c followed by the response s.
+            static constexpr size_t BYTE_SIZE = 2 * SecretKey::BYTE_SIZE;
+
+            Proof() {};
+
+            // The proof key for sk: G * k.
+            static Point ProofKey(const SecretKey& sk) {
+                return Point::Mul(Point::GetBase(), sk);
+            }
+
+            static Proof Prove(const SecretKey& sk, const Point& pk, const Point& m, const Point& z) {
+                mcl::bn::Fr r;
+                r.setRand();
+                mcl::bn::G1 t2, t3;
+                mcl::bn::G1::mul(t2, Point::GetBase().GetG1(), r);
+                mcl::bn::G1::mul(t3, m.GetG1(), r);
+
+                Proof proof;
+                proof.c = Challenge(pk, m, z, Point(t2), Point(t3));
+                // s = r - c * k
+                mcl::bn::Fr ck;
+                mcl::bn::Fr::mul(ck, proof.c, sk.GetFr());
+                mcl::bn::Fr::sub(proof.s, r, ck);
+                return proof;
+            }
+
+            // Recomputes t2 = G * s + Y * c and t3 = M * s + Z * c and checks
+            // that they hash to c.
+            bool Verify(const Point& pk, const Point& m, const Point& z) const {
+                mcl::bn::Fr scalars[2] = {s, c};
+                mcl::bn::G1 bases[2] = {Point::GetBase().GetG1(), pk.GetG1()};
+                mcl::bn::G1 t2, t3;
+                mcl::bn::G1::mulVec(t2, bases, scalars, 2);
+                bases[0] = m.GetG1();
+                bases[1] = z.GetG1();
+                mcl::bn::G1::mulVec(t3, bases, scalars, 2);
+                return Challenge(pk, m, z, Point(t2), Point(t3)) == c;
+            }
+
+            // One proof for every pair (ms[i], zs[i]). The server knows k, so
+            // its Z composite is M * k rather than a second MSM.
+            static Proof ProveBatch(const SecretKey& sk, const Point& pk, const vector<Point>& ms, const vector<Point>& zs) {
+                mcl::bn::G1 m;
+                Composites(pk, ms, zs, m, nullptr);
+                Point pm(m);
+                return Prove(sk, pk, pm, Point::Mul(pm, sk));
+            }
+
+            bool VerifyBatch(const Point& pk, const vector<Point>& ms, const vector<Point>& zs) const {
+                mcl::bn::G1 m, z;
+                Composites(pk, ms, zs, m, &z);
+                return Verify(pk, Point(m), Point(z));
+            }
+
+            // Writes the proof to buf and returns the number of bytes written,
+            // or 0 if buf is too small.
+            size_t Serialize(uint8_t* buf, size_t len) const {
+                if (len < BYTE_SIZE) {
+                    return 0;
+                }
+                memset(buf, 0, BYTE_SIZE);
+                if (c.serialize(buf, SecretKey::BYTE_SIZE) == 0 ||
+                    s.serialize(buf + SecretKey::BYTE_SIZE, SecretKey::BYTE_SIZE) == 0) {
+                    return 0;
+                }
+                return BYTE_SIZE;
+            }
+
+            // Reads the proof from buf and returns the number of bytes
+            // consumed, or 0 if buf does not hold a valid encoding.
+            size_t Deserialize(const uint8_t* buf, size_t len) {
+                if (len < BYTE_SIZE ||
+                    c.deserialize(buf, SecretKey::BYTE_SIZE) != SecretKey::BYTE_SIZE ||
+                    s.deserialize(buf + SecretKey::BYTE_SIZE, SecretKey::BYTE_SIZE) != SecretKey::BYTE_SIZE) {
+                    return 0;
+                }
+                return BYTE_SIZE;
+            }
+        private:
+            // c = H("voprf-dleq" || G || Y || M || Z || t2 || t3), reduced into Fr.
+            static mcl::bn::Fr Challenge(const Point& pk, const Point& m, const Point& z, const Point& t2, const Point& t3) {
+                static const char DST[] = "voprf-dleq";
+                const Point* points[] = {&Point::GetBase(), &pk, &m, &z, &t2, &t3};
+                uint8_t buf[sizeof(DST) - 1 + 6 * Point::BYTE_SIZE];
+                memcpy(buf, DST, sizeof(DST) - 1);
+                uint8_t* p = buf + sizeof(DST) - 1;
+                for (const Point* point : points) {
+                    memset(p, 0, Point::BYTE_SIZE);
+                    point->Serialize(p, Point::BYTE_SIZE);
+                    p += Point::BYTE_SIZE;
+                }
+                mcl::bn::Fr c;
+                c.setHashOf(buf, sizeof(buf));
+                return c;
+            }
+
+            // d_i = H("voprf-dleq-composite" || seed || i || M_i || Z_i), with
+            // seed = H(G || Y || n), and m = sum(d_i * M_i). z, when given,
+            // receives sum(d_i * Z_i). The points are normalized together
+            // first so that serializing them costs no further inversions.
+            static void Composites(const Point& pk, const vector<Point>& ms, const vector<Point>& zs, mcl::bn::G1& m, mcl::bn::G1* z) {
+                static const char DST[] = "voprf-dleq-composite";
+                const size_t n = ms.size();
+                if (zs.size() != n) {
+                    throw std::invalid_argument("voprf: composite input size mismatch");
+                }
+
+                vector<mcl::bn::G1> points(2 * n);
+                for (size_t i = 0; i < n; i++) {
+                    points[i] = ms[i].GetG1();
+                    points[n + i] = zs[i].GetG1();
+                }
+                mcl::bn::G1::normalizeVec(points.data(), points.data(), points.size());
+
+                uint8_t seed_in[2 * Point::BYTE_SIZE + 8];
+                memset(seed_in, 0, sizeof(seed_in));
+                Point::GetBase().Serialize(seed_in, Point::BYTE_SIZE);
+                pk.Serialize(seed_in + Point::BYTE_SIZE, Point::BYTE_SIZE);
+                PutIndex(seed_in + 2 * Point::BYTE_SIZE, n);
+                mcl::bn::Fr seed;
+                seed.setHashOf(seed_in, sizeof(seed_in));
+
+                uint8_t buf[sizeof(DST) - 1 + SecretKey::BYTE_SIZE + 8 + 2 * Point::BYTE_SIZE];
+                memcpy(buf, DST, sizeof(DST) - 1);
+                uint8_t* p = buf + sizeof(DST) - 1;
+                memset(p, 0, sizeof(buf) - (sizeof(DST) - 1));
+                seed.serialize(p, SecretKey::BYTE_SIZE);
+                p += SecretKey::BYTE_SIZE;
+
+                vector<mcl::bn::Fr> d(n);
+                for (size_t i = 0; i < n; i++) {
+                    PutIndex(p, i);
+                    points[i].serialize(p + 8, Point::BYTE_SIZE);
+                    points[n + i].serialize(p + 8 + Point::BYTE_SIZE, Point::BYTE_SIZE);
+                    d[i].setHashOf(buf, sizeof(buf));
+                }
+
+                mcl::bn::G1::mulVec(m, points.data(), d.data(), n);
+                if (z) {
+                    mcl::bn::G1::mulVec(*z, points.data() + n, d.data(), n);
+                }
+            }
+
+            static void PutIndex(uint8_t* p, uint64_t i) {
+                for (size_t b = 0; b < 8; b++) {
+                    p[b] = static_cast<uint8_t>(i >> (8 * b));
+                }
+            }
+
+            mcl::bn::Fr c;
+            mcl::bn::Fr s;
+    };
+}
+
+#endif // VOPRF_DLEQ_HPP
@@ -3,25 +3,71 @@
 
 #include "base.hpp"
 #include "utils.hpp"
-#include <mcl/bn256.hpp>
+#include "stats.hpp"
+#include "group.hpp"
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace voprf {
-    static void Init()
-    {
-        mcl::bn::initPairing();
+    // How much checking Deserialize does. STRICT rejects anything that is not
+    // a valid element of the prime-order subgroup and must be used for
+    // untrusted input. TRUSTED only decodes the coordinates (compressed
+    // points are still on the curve, since y is recovered from the curve
+    // equation) and skips the subgroup check; it is meant for data the
+    // caller produced itself, such as its own persisted keys and points.
+    enum Validation {
+        STRICT,
+        TRUSTED,
+    };
+
+    // Wire encoding of group elements. COMPRESSED stores x and a sign bit, so
+    // decoding takes a field square root to recover y. UNCOMPRESSED stores
+    // the affine x and y, twice the size, and decodes with only a curve
+    // equation check.
+    enum Format {
+        COMPRESSED,
+        UNCOMPRESSED,
+    };
+
+    // The mcl I/O mode for each wire format.
+    inline int IoMode(Format format) {
+        return format == UNCOMPRESSED ? mcl::IoEcAffineSerialize : mcl::IoSerialize;
     }
 
     class VerificationKey {
-        static const int MAX_PK_SIZE = 128;
-
         public:
+            // Serialized size of a compressed G2 element.
+            static constexpr size_t BYTE_SIZE = Group::G2_BYTES;
+            static constexpr size_t UNCOMPRESSED_BYTE_SIZE = 2 * BYTE_SIZE;
+
+            static constexpr size_t ByteSize(Format format) {
+                return format == UNCOMPRESSED ? UNCOMPRESSED_BYTE_SIZE : BYTE_SIZE;
+            }
+
             mcl::bn::G2 GetG2() const {
                 return v;
             }
 
+            // Writes the key to buf and returns the number of bytes written,
+            // or 0 if buf is too small.
+            size_t Serialize(uint8_t* buf, size_t len, Format format = COMPRESSED) const {
+                return v.serialize(buf, len, IoMode(format));
+            }
+
+            // Reads the key from buf and returns the number of bytes consumed,
+            // or 0 if buf does not hold a valid encoding.
+            size_t Deserialize(const uint8_t* buf, size_t len, Validation mode = STRICT, Format format = COMPRESSED) {
+                size_t read = v.deserialize(buf, len, IoMode(format));
+                if (read == 0 || (mode == STRICT && !v.isValidOrder())) {
+                    return 0;
+                }
+                return read;
+            }
+
             Bytes ToBytes() const {
-                uint8_t buf[MAX_PK_SIZE];
-                size_t len = v.serialize(buf, sizeof(buf));
+                uint8_t buf[BYTE_SIZE];
+                size_t len = Serialize(buf, sizeof(buf));
                 return Bytes(buf, buf + len);
             }
 
@@ -31,7 +77,7 @@ namespace voprf {
 
             static VerificationKey FromBytes(Bytes bytes) {
                 VerificationKey pk;
-                pk.v.deserialize(bytes.data(), bytes.size());
+                pk.Deserialize(bytes.data(), bytes.size());
                 return pk;
             }
 
@@ -40,10 +86,21 @@ namespace voprf {
                 return FromBytes(bytes);
             }
 
-            static mcl::bn::G2 GetBase() {
-                mcl::bn::G2 baseG2;
-                mcl::bn::mapToG2(baseG2, 1);
-                return baseG2;
+            // The fixed G2 generator. Only valid after InitBase().
+            static const mcl::bn::G2& GetBase() {
+                return BaseStorage().g2;
+            }
+
+            // Miller-loop line coefficients for GetBase(), for use with
+            // mcl::bn::precomputedMillerLoop.
+            static const vector<mcl::bn::Fp6>& GetBaseCoeffs() {
+                return BaseStorage().coeffs;
+            }
+
+            static void InitBase() {
+                Base& base = BaseStorage();
+                mcl::bn::mapToG2(base.g2, 1);
+                mcl::bn::precomputeG2(base.coeffs, base.g2);
             }
 
             VerificationKey() {};
@@ -53,20 +110,43 @@ namespace voprf {
                 return v == other.v;
             }
         private:
+            struct Base {
+                mcl::bn::G2 g2;
+                vector<mcl::bn::Fp6> coeffs;
+            };
+
+            static Base& BaseStorage() {
+                static Base base;
+                return base;
+            }
+
             mcl::bn::G2 v;
     };
 
     class SecretKey {
-        static const int SK_SIZE = 32;
-
         public:
+            // Serialized size of an Fr element.
+            static constexpr size_t BYTE_SIZE = Group::SCALAR_BYTES;
+
             SecretKey() {};
             
             SecretKey(mcl::bn::Fr s): s(s) {};
 
+            // Writes the key to buf and returns the number of bytes written,
+            // or 0 if buf is too small.
+            size_t Serialize(uint8_t* buf, size_t len) const {
+                return s.serialize(buf, len);
+            }
+
+            // Reads the key from buf and returns the number of bytes consumed,
+            // or 0 if buf does not hold a valid encoding.
+            size_t Deserialize(const uint8_t* buf, size_t len) {
+                return s.deserialize(buf, len);
+            }
+
             Bytes ToBytes() const {
-                uint8_t buf[SK_SIZE];
-                size_t len = s.serialize(buf, sizeof(buf));
+                uint8_t buf[BYTE_SIZE];
+                size_t len = Serialize(buf, sizeof(buf));
                 return Bytes(buf, buf + len);
             }
 
@@ -76,7 +156,7 @@ namespace voprf {
 
             static SecretKey FromBytes(Bytes bytes) {
                 SecretKey sk;
-                sk.s.deserialize(bytes.data(), bytes.size());
+                sk.Deserialize(bytes.data(), bytes.size());
                 return sk;
             }
 
@@ -107,6 +187,35 @@ namespace voprf {
                 return SecretKey(inv_s);
             }
 
+            // Inverts every element of v in place with a single field
+            // inversion (Montgomery's trick). Returns false, leaving v
+            // untouched, if any element is zero.
+            static bool InverseBatch(vector<mcl::bn::Fr>& v) {
+                size_t n = v.size();
+                if (n == 0) {
+                    return true;
+                }
+                vector<mcl::bn::Fr> prefix(n);
+                prefix[0] = v[0];
+                for (size_t i = 1; i < n; i++) {
+                    mcl::bn::Fr::mul(prefix[i], prefix[i - 1], v[i]);
+                }
+                if (prefix[n - 1].isZero()) {
+                    return false;
+                }
+
+                mcl::bn::Fr inv;
+                mcl::bn::Fr::inv(inv, prefix[n - 1]);
+                for (size_t i = n - 1; i > 0; i--) {
+                    mcl::bn::Fr v_inv;
+                    mcl::bn::Fr::mul(v_inv, inv, prefix[i - 1]);
+                    mcl::bn::Fr::mul(inv, inv, v[i]);
+                    v[i] = v_inv;
+                }
+                v[0] = inv;
+                return true;
+            }
+
             bool operator==(const SecretKey& other) const {
                 return s == other.s;
             }
@@ -115,16 +224,43 @@ namespace voprf {
     };
 
     class Point {
-        static const int MAX_Pt_SIZE = 128;
-
         public:
+            // Serialized size of a compressed G1 element.
+            static constexpr size_t BYTE_SIZE = Group::G1_BYTES;
+            static constexpr size_t UNCOMPRESSED_BYTE_SIZE = 2 * BYTE_SIZE;
+
+            static constexpr size_t ByteSize(Format format) {
+                return format == UNCOMPRESSED ? UNCOMPRESSED_BYTE_SIZE : BYTE_SIZE;
+            }
+
             Point() {};
 
             Point(mcl::bn::G1 v): v(v) {};
 
+            // Writes the point to buf and returns the number of bytes written,
+            // or 0 if buf is too small.
+            // Either format costs a single inversion to reach affine
+            // coordinates, none if the point is already normalized.
+            size_t Serialize(uint8_t* buf, size_t len, Format format = COMPRESSED) const {
+                return v.serialize(buf, len, IoMode(format));
+            }
+
+            // Reads the point from buf and returns the number of bytes
+            // consumed, or 0 if buf does not hold a valid encoding.
+            size_t Deserialize(const uint8_t* buf, size_t len, Validation mode = STRICT, Format format = COMPRESSED) {
+                size_t read = v.deserialize(buf, len, IoMode(format));
+                if (read == 0) {
+                    return 0;
+                }
+                if (!Group::G1_COFACTOR_ONE && mode == STRICT && !v.isValidOrder()) {
+                    return 0;
+                }
+                return read;
+            }
+
             Bytes ToBytes() const {
-                uint8_t buf[MAX_Pt_SIZE];
-                size_t len = v.serialize(buf, sizeof(buf));
+                uint8_t buf[BYTE_SIZE];
+                size_t len = Serialize(buf, sizeof(buf));
                 return Bytes(buf, buf + len);
             }
 
@@ -134,7 +270,7 @@ namespace voprf {
 
             static Point FromBytes(Bytes bytes) {
                 Point p;
-                p.v.deserialize(bytes.data(), bytes.size());
+                p.Deserialize(bytes.data(), bytes.size());
                 return p;
             }
 
@@ -142,14 +278,68 @@ namespace voprf {
                 return FromBytes(Utils::DecodeBase64(s));
             }
 
-            static Point HashToPoint(string m) {
+            // Hashes msg straight from the caller's buffer; no copies are made.
+            static Point HashToPoint(const uint8_t* msg, size_t len) {
+                VOPRF_STATS_TIMER(VOPRF_STATS_OP_HASH_TO_POINT);
+                return MapToPoint(HashToField(msg, len));
+            }
+
+            // The two halves of HashToPoint: a cheap digest into Fp, then the
+            // expensive map onto the curve.
+            static mcl::bn::Fp HashToField(const uint8_t* msg, size_t len) {
                 mcl::bn::Fp t;
-                t.setHashOf(m);
+                t.setHashOf(msg, len);
+                return t;
+            }
+
+            static Point MapToPoint(const mcl::bn::Fp& t) {
                 mcl::bn::G1 v;
                 mcl::bn::mapToG1(v, t);
                 return Point(v);
             }
 
+            static Point HashToPoint(const string& m) {
+                return HashToPoint(reinterpret_cast<const uint8_t*>(m.data()), m.size());
+            }
+
+            // Serializes points[0..n) back to back into out, which must hold
+            // n * ByteSize(format) bytes. Points are normalized to affine in
+            // blocks with G1::normalizeVec, which shares one field inversion
+            // across the block (Montgomery's trick) instead of paying one per
+            // point in Serialize. Returns false if any point fails to
+            // serialize.
+            template <typename Get>
+            static bool SerializeBatch(Get get, size_t n, uint8_t* out, Format format = COMPRESSED) {
+                static constexpr size_t BLOCK = 256;
+                const size_t size = ByteSize(format);
+                mcl::bn::G1 block[BLOCK];
+                for (size_t begin = 0; begin < n; begin += BLOCK) {
+                    size_t count = std::min(BLOCK, n - begin);
+                    for (size_t i = 0; i < count; i++) {
+                        block[i] = get(begin + i).v;
+                    }
+                    mcl::bn::G1::normalizeVec(block, block, count);
+                    for (size_t i = 0; i < count; i++) {
+                        if (block[i].serialize(out + (begin + i) * size, size, IoMode(format)) != size) {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }
+
+            // The fixed G1 generator, used for DLEQ proof keys. Only valid
+            // after InitBase().
+            static const Point& GetBase() {
+                return BaseStorage();
+            }
+
+            static void InitBase() {
+                mcl::bn::G1 g1;
+                mcl::bn::mapToG1(g1, 1);
+                BaseStorage() = Point(g1);
+            }
+
             static Point Mul(const Point& p, const SecretKey& sk) {
                 mcl::bn::G1 v;
                 mcl::bn::G1::mul(v, p.v, sk.GetFr());
@@ -168,9 +358,81 @@ namespace voprf {
                 return v != other.v;
             }
         private:
+            static Point& BaseStorage() {
+                static Point base;
+                return base;
+            }
+
             mcl::bn::G1 v;
     };
 
+    // Zeroes len bytes at p through a volatile pointer, so the stores are not
+    // dropped as dead writes to memory that is about to be freed.
+    inline void SecureWipe(void* p, size_t len) {
+        volatile uint8_t* bytes = static_cast<volatile uint8_t*>(p);
+        for (size_t i = 0; i < len; i++) {
+            bytes[i] = 0;
+        }
+    }
+
+    // A server key prepared for repeated scalar multiplications. mcl converts
+    // an Fr out of Montgomery form into plain limbs on every G1::mul; this
+    // does that once per key and feeds the limbs to G1::mulArray directly.
+    class PreparedKey {
+        public:
+            PreparedKey() {};
+
+            explicit PreparedKey(const SecretKey& sk): sk(sk) {
+                mcl::fp::Block b;
+                sk.GetFr().getBlock(b);
+                units.assign(b.p, b.p + b.n);
+            }
+
+            PreparedKey(const PreparedKey&) = default;
+            PreparedKey& operator=(const PreparedKey&) = default;
+
+            // Wipes the scalar and its limbs.
+            ~PreparedKey() {
+                SecureWipe(&sk, sizeof(sk));
+                SecureWipe(units.data(), units.size() * sizeof(mcl::fp::Unit));
+            }
+
+            Point Mul(const Point& p) const {
+                mcl::bn::G1 v;
+                mcl::bn::G1::mulArray(v, p.GetG1(), units.data(), units.size());
+                return Point(v);
+            }
+
+            const SecretKey& GetSecretKey() const {
+                return sk;
+            }
+        private:
+            SecretKey sk;
+            vector<mcl::fp::Unit> units;
+    };
+
+    // A verification key with its Miller-loop line coefficients precomputed,
+    // so pairings against it only do the G1-side work.
+    class PreparedVerificationKey {
+        public:
+            PreparedVerificationKey() {};
+
+            explicit PreparedVerificationKey(const VerificationKey& pk): pk(pk) {
+                mcl::bn::precomputeG2(coeffs, pk.GetG2());
+            }
+
+            const VerificationKey& GetVerificationKey() const {
+                return pk;
+            }
+
+            const vector<mcl::bn::Fp6>& GetCoeffs() const {
+                return coeffs;
+            }
+        private:
+            VerificationKey pk;
+            vector<mcl::bn::Fp6> coeffs;
+    };
+
     class Pairing {
         public:
             Pairing() {};
@@ -193,12 +455,52 @@ namespace voprf {
                 return Pairing(e);
             }
 
+            // Checks e(x, pk) == e(y, g2) as e(x, pk) * e(-y, g2) == 1, sharing
+            // one Miller loop and a single final exponentiation.
+            static bool Check(const Point& x, const PreparedVerificationKey& pk, const Point& y) {
+                mcl::bn::G1 neg_y;
+                mcl::bn::G1::neg(neg_y, y.GetG1());
+                mcl::bn::Fp12 e;
+                mcl::bn::precomputedMillerLoop2(e, x.GetG1(), pk.GetCoeffs(), neg_y, VerificationKey::GetBaseCoeffs());
+                mcl::bn::finalExp(e, e);
+                return e.isOne();
+            }
+
+            // As above for a key without precomputed lines: only the
+            // generator's side of the Miller loop is precomputed.
+            static bool Check(const Point& x, const VerificationKey& pk, const Point& y) {
+                mcl::bn::G1 neg_y;
+                mcl::bn::G1::neg(neg_y, y.GetG1());
+                mcl::bn::Fp12 e;
+                mcl::bn::precomputedMillerLoop2mixed(e, x.GetG1(), pk.GetG2(), neg_y, VerificationKey::GetBaseCoeffs());
+                mcl::bn::finalExp(e, e);
+                return e.isOne();
+            }
+
             bool operator==(const Pairing& other) const {
                 return e == other.e;
             }
         private:
             mcl::bn::Fp12 e;
     };
+
+    inline void Init()
+    {
+        mcl::bn::initPairing(Group::Param());
+        // Subgroup checks are done explicitly by Deserialize, according to
+        // its Validation mode, rather than unconditionally inside mcl.
+        mcl::bn::verifyOrderG1(false);
+        mcl::bn::verifyOrderG2(false);
+        // The wire sizes are compile-time constants; make sure they match the
+        // curve mcl was actually initialized with.
+        if (mcl::bn::Fr::getByteSize() != SecretKey::BYTE_SIZE ||
+            mcl::bn::Fp::getByteSize() != Point::BYTE_SIZE ||
+            mcl::bn::Fp::getByteSize() * 2 != VerificationKey::BYTE_SIZE) {
+            throw std::runtime_error("voprf: unexpected curve element sizes");
+        }
+        VerificationKey::InitBase();
+        Point::InitBase();
+    }
 }
 
 #endif // VOPRF_ELEMENTS_HPP
\ No newline at end of file
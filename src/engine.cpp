@@ -0,0 +1,222 @@
+#include "voprf/voprf.h"
+
+#include "capi.hpp"
+#include "engine.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+//----------------------------------------------------------------
+// Asynchronous Engine
+//----------------------------------------------------------------
+
+namespace {
+    // The largest range a task runs without splitting it further. Ranges
+    // run through the batch entry points where there is one, so a grain
+    // should be big enough for those to pay off.
+    const size_t MAX_GRAIN = 64;
+
+    struct Job {
+        voprf_job_t spec;
+        uint64_t id;
+        voprf::Engine* engine;
+        size_t grain;
+        std::atomic<size_t> remaining; // items not yet run
+        std::atomic<int> status{VOPRF_SUCCESS};
+    };
+
+    int check_job(const voprf_job_t& job) {
+        if (job.n == 0) {
+            return VOPRF_ERROR_INVALID_ARGUMENT;
+        }
+        switch (job.type) {
+            case VOPRF_JOB_BLIND:
+                return job.msgs && job.msg_lens && job.factors && job.out_points ? VOPRF_SUCCESS : VOPRF_ERROR_NULL_ARG;
+            case VOPRF_JOB_EVALUATE:
+                return job.ctx && job.points && job.out_points ? VOPRF_SUCCESS : VOPRF_ERROR_NULL_ARG;
+            case VOPRF_JOB_UNBLIND:
+                return job.points && job.factors && job.out_points ? VOPRF_SUCCESS : VOPRF_ERROR_NULL_ARG;
+            case VOPRF_JOB_VERIFY:
+                return job.verifier && job.msgs && job.msg_lens && job.points && job.results ? VOPRF_SUCCESS : VOPRF_ERROR_NULL_ARG;
+        }
+        return VOPRF_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Runs items [begin, end) of a job and returns the first failure.
+    int run_items(const voprf_job_t& job, size_t begin, size_t end) {
+        switch (job.type) {
+            case VOPRF_JOB_BLIND:
+                for (size_t i = begin; i < end; i++) {
+                    int status = voprf_blind_into(job.msgs[i], job.msg_lens[i], job.factors[i], job.out_points[i]);
+                    if (status != VOPRF_SUCCESS) {
+                        return status;
+                    }
+                }
+                return VOPRF_SUCCESS;
+            case VOPRF_JOB_EVALUATE:
+                return voprf_server_ctx_evaluate_batch_into(job.ctx, job.points + begin, end - begin, job.out_points + begin, 1);
+            case VOPRF_JOB_UNBLIND:
+                for (size_t i = begin; i < end; i++) {
+                    int status = voprf_unblind_into(job.points[i], job.factors[i], job.out_points[i]);
+                    if (status != VOPRF_SUCCESS) {
+                        return status;
+                    }
+                }
+                return VOPRF_SUCCESS;
+            case VOPRF_JOB_VERIFY: {
+                bool all_valid;
+                return voprf_verifier_verify_batch(job.verifier, job.msgs + begin, job.msg_lens + begin, job.points + begin,
+                                                   end - begin, job.results + begin, &all_valid, 1);
+            }
+        }
+        return VOPRF_ERROR_INVALID_ARGUMENT;
+    }
+
+    void complete(const Job& job) {
+        if (job.spec.callback) {
+            // Release first so that the callback can submit more work.
+            job.engine->Release(job.spec.n);
+            job.spec.callback(job.spec.user_data, job.id, job.status.load());
+        } else {
+            job.engine->Post({job.id, job.status.load(), job.spec.user_data});
+            job.engine->Release(job.spec.n);
+        }
+    }
+
+    // Hands the upper half of the range to the pool until what is left fits
+    // in one grain, then runs that. The halves land on this worker's own
+    // deque, where idle workers steal the largest first.
+    void run_range(const std::shared_ptr<Job>& job, size_t begin, size_t end) {
+        while (end - begin > job->grain) {
+            size_t mid = begin + (end - begin) / 2;
+            try {
+                job->engine->Run([job, mid, end] { run_range(job, mid, end); });
+            } catch (...) {
+                break; // cannot queue: run the whole range here instead
+            }
+            end = mid;
+        }
+
+        int status;
+        try {
+            status = run_items(job->spec, begin, end);
+        } catch (...) {
+            status = VOPRF_ERROR_CPP_EXCEPTION;
+        }
+        if (status != VOPRF_SUCCESS) {
+            int expected = VOPRF_SUCCESS;
+            job->status.compare_exchange_strong(expected, status);
+        }
+        if (job->remaining.fetch_sub(end - begin) == end - begin) {
+            complete(*job);
+        }
+    }
+
+    int submit(voprf_engine_t* engine, const voprf_job_t* job, bool wait, uint64_t* job_id, bool* accepted) {
+        CHECK_NULL_ARG(engine);
+        CHECK_NULL_ARG(job);
+        CHECK_NULL_ARG(job_id);
+        int check = check_job(*job);
+        if (check != VOPRF_SUCCESS) {
+            return VOPRF_FAIL(check);
+        }
+        VOPRF_TRY
+            std::shared_ptr<Job> state = std::make_shared<Job>();
+            state->spec = *job;
+            state->engine = &engine->engine;
+            state->remaining = job->n;
+            size_t per_thread = (job->n + 4 * engine->engine.Threads() - 1) / (4 * engine->engine.Threads());
+            state->grain = std::min(std::max<size_t>(per_thread, 1), MAX_GRAIN);
+
+            if (!engine->engine.Admit(job->n, wait)) {
+                *accepted = false;
+                return VOPRF_SUCCESS;
+            }
+            state->id = engine->engine.NextId();
+            *job_id = state->id;
+            try {
+                engine->engine.Run([state] { run_range(state, 0, state->spec.n); });
+            } catch (...) {
+                engine->engine.Release(job->n);
+                throw;
+            }
+            if (accepted) {
+                *accepted = true;
+            }
+            return VOPRF_SUCCESS;
+        VOPRF_CATCH
+    }
+}
+
+extern "C" int voprf_engine_create(size_t num_threads, size_t max_pending, voprf_engine_t** engine) {
+    CHECK_NULL_ARG(engine);
+    VOPRF_TRY
+        *engine = new voprf_engine_t(num_threads, max_pending);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_engine_destroy(voprf_engine_t* engine) {
+    delete engine;
+}
+
+extern "C" int voprf_engine_submit(voprf_engine_t* engine, const voprf_job_t* job, uint64_t* job_id) {
+    return submit(engine, job, true, job_id, nullptr);
+}
+
+extern "C" int voprf_engine_try_submit(voprf_engine_t* engine, const voprf_job_t* job, uint64_t* job_id, bool* accepted) {
+    CHECK_NULL_ARG(accepted);
+    return submit(engine, job, false, job_id, accepted);
+}
+
+extern "C" int voprf_engine_poll(voprf_engine_t* engine, voprf_job_completion_t* completions, size_t max, size_t* count) {
+    CHECK_NULL_ARG(engine);
+    CHECK_NULL_ARG(count);
+    if (max > 0) {
+        CHECK_NULL_ARG(completions);
+    }
+    VOPRF_TRY
+        voprf::Engine::Completion buf[64];
+        size_t total = 0;
+        while (total < max) {
+            size_t got = engine->engine.Poll(buf, std::min(max - total, sizeof(buf) / sizeof(buf[0])));
+            for (size_t i = 0; i < got; i++) {
+                completions[total + i] = voprf_job_completion_t{buf[i].id, buf[i].status, buf[i].user_data};
+            }
+            total += got;
+            if (got == 0) {
+                break;
+            }
+        }
+        *count = total;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_engine_get_fd(const voprf_engine_t* engine, int* fd) {
+    CHECK_NULL_ARG(engine);
+    CHECK_NULL_ARG(fd);
+#ifdef VOPRF_HAVE_EVENTFD
+    *fd = engine->engine.Fd();
+    return VOPRF_SUCCESS;
+#else
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+#endif
+}
+
+extern "C" int voprf_engine_pending(const voprf_engine_t* engine, size_t* pending) {
+    CHECK_NULL_ARG(engine);
+    CHECK_NULL_ARG(pending);
+    VOPRF_TRY
+        *pending = engine->engine.Pending();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_engine_num_threads(const voprf_engine_t* engine, size_t* num_threads) {
+    CHECK_NULL_ARG(engine);
+    CHECK_NULL_ARG(num_threads);
+    *num_threads = engine->engine.Threads();
+    return VOPRF_SUCCESS;
+}
@@ -0,0 +1,274 @@
+#ifndef VOPRF_ENGINE_HPP
+#define VOPRF_ENGINE_HPP
+
+#include "base.hpp"
+#include "parallel.hpp"
+
+#if defined(__linux__)
+#define VOPRF_HAVE_EVENTFD 1
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace voprf {
+    // A fixed pool of worker threads, each with its own task deque. A worker
+    // takes tasks from the back of its own deque and, when that is empty,
+    // steals from the front of the others. Tasks submitted from a worker go
+    // onto that worker's deque, so a task that splits its range and submits
+    // the halves keeps the work it is about to do local, while idle workers
+    // steal the largest pieces that are left. Tasks must not throw.
+    class ThreadPool {
+        public:
+            typedef std::function<void()> Task;
+
+            explicit ThreadPool(size_t threads) {
+                threads = std::max<size_t>(threads, 1);
+                for (size_t i = 0; i < threads; i++) {
+                    queues.emplace_back(new Queue());
+                }
+                try {
+                    for (size_t i = 0; i < threads; i++) {
+                        workers.emplace_back([this, i] { Work(i); });
+                    }
+                } catch (...) {
+                    Stop();
+                    throw;
+                }
+            }
+
+            // Runs every task already submitted, then joins the workers.
+            ~ThreadPool() {
+                Stop();
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            size_t Size() const {
+                return queues.size();
+            }
+
+            void Submit(Task task) {
+                size_t q = current == this ? current_index : next++ % queues.size();
+                {
+                    std::lock_guard<std::mutex> lock(queues[q]->mutex);
+                    queues[q]->tasks.push_back(std::move(task));
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queued++;
+                }
+                wake.notify_one();
+            }
+        private:
+            struct Queue {
+                std::mutex mutex;
+                std::deque<Task> tasks;
+            };
+
+            void Stop() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                wake.notify_all();
+                for (auto& w : workers) {
+                    w.join();
+                }
+                workers.clear();
+            }
+
+            bool Take(size_t self, Task& task) {
+                {
+                    Queue& own = *queues[self];
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    if (!own.tasks.empty()) {
+                        task = std::move(own.tasks.back());
+                        own.tasks.pop_back();
+                        return true;
+                    }
+                }
+                for (size_t k = 1; k < queues.size(); k++) {
+                    Queue& victim = *queues[(self + k) % queues.size()];
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if (!victim.tasks.empty()) {
+                        task = std::move(victim.tasks.front());
+                        victim.tasks.pop_front();
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // queued counts the tasks sitting in the deques. A worker claims
+            // one before it looks for it, so its search always ends; it can
+            // only miss on a pass while other workers are mid-take.
+            void Work(size_t self) {
+                current = this;
+                current_index = self;
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        wake.wait(lock, [this] { return queued > 0 || stopping; });
+                        if (queued == 0) {
+                            return;
+                        }
+                        queued--;
+                    }
+                    Task task;
+                    while (!Take(self, task)) {
+                        std::this_thread::yield();
+                    }
+                    task();
+                }
+            }
+
+            static inline thread_local const ThreadPool* current = nullptr;
+            static inline thread_local size_t current_index = 0;
+
+            vector<std::unique_ptr<Queue>> queues;
+            vector<std::thread> workers;
+            std::atomic<size_t> next{0};
+            std::mutex mutex;
+            std::condition_variable wake;
+            size_t queued = 0;
+            bool stopping = false;
+    };
+
+    // The bookkeeping around a ThreadPool for asynchronous jobs: admission
+    // against a bound on outstanding items, job IDs, and a queue of
+    // completions for callers that poll instead of taking callbacks. On Linux
+    // the completion queue is mirrored by an eventfd that is readable exactly
+    // while the queue is non-empty, so it can sit in the caller's event loop.
+    class Engine {
+        public:
+            struct Completion {
+                uint64_t id;
+                int status;
+                void* user_data;
+            };
+
+            // max_pending bounds the number of submitted items not yet
+            // completed; 0 means no bound.
+            Engine(size_t threads, size_t max_pending): max_pending(max_pending), pool(Parallel::ThreadCount(threads)) {
+#ifdef VOPRF_HAVE_EVENTFD
+                fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (fd < 0) {
+                    throw std::system_error(errno, std::generic_category(), "voprf: eventfd");
+                }
+#endif
+            }
+
+            // Waits for every admitted job to complete. The pool, declared
+            // last, is joined before the other members go away.
+            ~Engine() {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    space.wait(lock, [this] { return pending == 0; });
+                }
+#ifdef VOPRF_HAVE_EVENTFD
+                close(fd);
+#endif
+            }
+
+            Engine(const Engine&) = delete;
+            Engine& operator=(const Engine&) = delete;
+
+            // Reserves room for n items. If the engine is full, waits for
+            // room when wait is set and returns false otherwise. A job larger
+            // than the bound is admitted once the engine is empty.
+            bool Admit(size_t n, bool wait) {
+                std::unique_lock<std::mutex> lock(mutex);
+                auto fits = [&] {
+                    return max_pending == 0 || pending == 0 || (n <= max_pending && pending <= max_pending - n);
+                };
+                if (!fits()) {
+                    if (!wait) {
+                        return false;
+                    }
+                    space.wait(lock, fits);
+                }
+                pending += n;
+                return true;
+            }
+
+            void Release(size_t n) {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending -= n;
+                space.notify_all();
+            }
+
+            uint64_t NextId() {
+                return ++last_id;
+            }
+
+            void Run(ThreadPool::Task task) {
+                pool.Submit(std::move(task));
+            }
+
+            void Post(const Completion& completion) {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                done.push_back(completion);
+#ifdef VOPRF_HAVE_EVENTFD
+                uint64_t one = 1;
+                ssize_t n = write(fd, &one, sizeof(one));
+                (void)n;
+#endif
+            }
+
+            // Moves up to max completions into out and returns how many.
+            size_t Poll(Completion* out, size_t max) {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                size_t n = std::min(max, done.size());
+                std::copy(done.begin(), done.begin() + n, out);
+                done.erase(done.begin(), done.begin() + n);
+#ifdef VOPRF_HAVE_EVENTFD
+                if (done.empty()) {
+                    uint64_t count;
+                    ssize_t r = read(fd, &count, sizeof(count));
+                    (void)r;
+                }
+#endif
+                return n;
+            }
+
+            // The completion eventfd, or -1 where there is none.
+            int Fd() const {
+                return fd;
+            }
+
+            size_t Pending() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                return pending;
+            }
+
+            size_t Threads() const {
+                return pool.Size();
+            }
+        private:
+            const size_t max_pending;
+            mutable std::mutex mutex;
+            std::condition_variable space;
+            size_t pending = 0;
+            std::atomic<uint64_t> last_id{0};
+
+            std::mutex done_mutex;
+            std::deque<Completion> done;
+            int fd = -1;
+
+            ThreadPool pool;
+    };
+}
+
+#endif // VOPRF_ENGINE_HPP
@@ -0,0 +1,102 @@
+#include "epoch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace voprf {
+    namespace epoch {
+        namespace {
+            const uint64_t IDLE = UINT64_MAX;
+
+            // One thread's announcement. Only the owning thread writes it;
+            // depth is never read by anyone else.
+            struct alignas(64) Slot {
+                std::atomic<uint64_t> epoch{IDLE};
+                unsigned depth = 0;
+            };
+
+            std::atomic<uint64_t> global{0};
+
+            class Registry {
+                public:
+                    // Deliberately leaked so that thread-local slots can still
+                    // unregister during static destruction.
+                    static Registry& Get() {
+                        static Registry* registry = new Registry();
+                        return *registry;
+                    }
+
+                    void Add(Slot* s) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        live.push_back(s);
+                    }
+
+                    void Remove(Slot* s) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        live.erase(std::find(live.begin(), live.end(), s));
+                    }
+
+                    uint64_t Oldest() {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        uint64_t oldest = IDLE;
+                        for (Slot* s : live) {
+                            oldest = std::min(oldest, s->epoch.load(std::memory_order_seq_cst));
+                        }
+                        return oldest;
+                    }
+                private:
+                    std::mutex mutex;
+                    std::vector<Slot*> live;
+            };
+
+            // Registers the calling thread's slot on first use and removes it
+            // when the thread exits.
+            struct LocalSlot {
+                Slot* slot;
+
+                LocalSlot(): slot(new Slot()) {
+                    Registry::Get().Add(slot);
+                }
+
+                ~LocalSlot() {
+                    Registry::Get().Remove(slot);
+                    delete slot;
+                }
+            };
+
+            Slot& Local() {
+                thread_local LocalSlot local;
+                return *local.slot;
+            }
+        }
+
+        // The announcement is a sequentially consistent store, and so are
+        // the reader's loads of the structure and the writer's unlink,
+        // Advance and scan. A reader that loaded an unlinked pointer
+        // therefore announced before the unlink, with an epoch no later than
+        // the tag, and the writer's scan sees that announcement.
+        void Enter() {
+            Slot& s = Local();
+            if (s.depth++ == 0) {
+                s.epoch.store(global.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+            }
+        }
+
+        void Exit() {
+            Slot& s = Local();
+            if (--s.depth == 0) {
+                s.epoch.store(IDLE, std::memory_order_release);
+            }
+        }
+
+        uint64_t Advance() {
+            return global.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        uint64_t Oldest() {
+            return Registry::Get().Oldest();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef VOPRF_EPOCH_HPP
+#define VOPRF_EPOCH_HPP
+
+#include <cstdint>
+
+// Epoch-based reclamation, for read-mostly structures whose readers must
+// neither take a lock nor update a shared reference count.
+//
+// A reader wraps its accesses in an epoch::Guard, which announces the
+// current global epoch in a slot owned by its thread. The slot sits on a
+// cache line of its own and is written only by that thread, so readers on
+// different threads share nothing they write. A writer that has unlinked an
+// object calls Advance() and keeps the returned tag with it; the object may
+// be freed once the tag is below Oldest(), since every thread that could
+// still be reading it announced an epoch no later than the tag.
+
+namespace voprf {
+    namespace epoch {
+        void Enter();
+        void Exit();
+
+        // Moves the global epoch on and returns the tag for objects unlinked
+        // before the call.
+        uint64_t Advance();
+
+        // The oldest epoch announced by a thread currently inside a guard, or
+        // UINT64_MAX if there is none.
+        uint64_t Oldest();
+
+        // Guards nest; only the outermost one announces and withdraws.
+        class Guard {
+            public:
+                Guard() {
+                    Enter();
+                }
+
+                ~Guard() {
+                    Exit();
+                }
+
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+        };
+    }
+}
+
+#endif // VOPRF_EPOCH_HPP
@@ -0,0 +1,56 @@
+#ifndef VOPRF_GROUP_HPP
+#define VOPRF_GROUP_HPP
+
+// Compile-time selection of the pairing group.
+//
+// Each backend is a traits struct giving the mcl curve parameters and the
+// serialized element sizes. The library is built against exactly one of
+// them (VOPRF_CURVE_* is set per build target), so every size below is a
+// constant expression and there is no runtime dispatch. mcl exposes the same
+// mcl::bn types for every curve, sized by the header that is included, so
+// the element classes use those types directly and take their sizes from
+// Group.
+
+#if defined(VOPRF_CURVE_BLS12_381)
+#include <mcl/bls12_381.hpp>
+#else
+#include <mcl/bn256.hpp>
+#endif
+
+#include <cstddef>
+
+namespace voprf {
+    struct BN254 {
+        static constexpr const char* NAME = "BN254";
+        // Fr scalar, compressed G1 (one Fp) and compressed G2 (one Fp2).
+        static constexpr size_t SCALAR_BYTES = 32;
+        static constexpr size_t G1_BYTES = 32;
+        static constexpr size_t G2_BYTES = 64;
+        // Every point on the G1 curve is in the prime-order subgroup.
+        static constexpr bool G1_COFACTOR_ONE = true;
+
+        static const mcl::CurveParam& Param() {
+            return mcl::BN254;
+        }
+    };
+
+    struct BLS12_381 {
+        static constexpr const char* NAME = "BLS12-381";
+        static constexpr size_t SCALAR_BYTES = 32;
+        static constexpr size_t G1_BYTES = 48;
+        static constexpr size_t G2_BYTES = 96;
+        static constexpr bool G1_COFACTOR_ONE = false;
+
+        static const mcl::CurveParam& Param() {
+            return mcl::BLS12_381;
+        }
+    };
+
+#if defined(VOPRF_CURVE_BLS12_381)
+    typedef BLS12_381 Group;
+#else
+    typedef BN254 Group;
+#endif
+}
+
+#endif // VOPRF_GROUP_HPP
@@ -0,0 +1,132 @@
+#ifndef VOPRF_HASH_CACHE_HPP
+#define VOPRF_HASH_CACHE_HPP
+
+#include "base.hpp"
+#include "elements.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace voprf {
+    // A bounded, thread-safe LRU cache of HashToPoint results.
+    //
+    // Entries are keyed by the Fp digest of the message (the output of
+    // Point::HashToField), so a lookup costs one SHA-256 and skips only the
+    // map-to-curve step, which is the expensive part. Cached points are
+    // stored in normalized (affine) form. The cache is split into up to
+    // SHARDS independently locked shards to keep contention low; a small
+    // cache uses fewer shards so that every shard holds at least one entry.
+    class HashCache {
+        static constexpr size_t SHARDS = 16;
+        // A serialized Fp element, the same size as a compressed G1 point.
+        static constexpr size_t KEY_SIZE = Point::BYTE_SIZE;
+
+        typedef std::array<uint8_t, KEY_SIZE> Key;
+
+        // The key is already a hash output, so any slice of its low-order
+        // bytes is uniformly distributed (the top bytes are not, as the
+        // value is below the field modulus). The map buckets and the shard
+        // choice read different slices, so the entries of one shard still
+        // spread over all of its buckets.
+        static uint64_t Slice(const Key& k, size_t offset) {
+            uint64_t h;
+            memcpy(&h, k.data() + offset, sizeof(h));
+            return h;
+        }
+
+        struct KeyHash {
+            size_t operator()(const Key& k) const {
+                return static_cast<size_t>(Slice(k, 0));
+            }
+        };
+
+        static_assert(KEY_SIZE > 2 * sizeof(uint64_t), "hash cache key too short to slice");
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<std::pair<Key, Point>> lru; // most recently used first
+            std::unordered_map<Key, std::list<std::pair<Key, Point>>::iterator, KeyHash> index;
+            size_t capacity = 0;
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+        };
+
+        public:
+            struct Stats {
+                uint64_t hits;
+                uint64_t misses;
+                size_t size;
+            };
+
+            // capacity is the total number of cached points across all shards.
+            explicit HashCache(size_t capacity): num_shards(std::min(std::max<size_t>(capacity, 1), SHARDS)) {
+                for (size_t i = 0; i < num_shards; i++) {
+                    shards[i].capacity = capacity / num_shards + (i < capacity % num_shards ? 1 : 0);
+                    shards[i].index.reserve(shards[i].capacity);
+                }
+            }
+
+            HashCache(const HashCache&) = delete;
+            HashCache& operator=(const HashCache&) = delete;
+
+            Point HashToPoint(const uint8_t* msg, size_t len) {
+                mcl::bn::Fp t = Point::HashToField(msg, len);
+                Key key;
+                key.fill(0);
+                t.serialize(key.data(), key.size());
+                Shard& shard = shards[Slice(key, sizeof(uint64_t)) % num_shards];
+
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    auto it = shard.index.find(key);
+                    if (it != shard.index.end()) {
+                        shard.hits++;
+                        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                        return it->second->second;
+                    }
+                    shard.misses++;
+                }
+
+                // Map outside the lock; a concurrent miss on the same key
+                // just computes the same point twice.
+                mcl::bn::G1 v = Point::MapToPoint(t).GetG1();
+                v.normalize();
+                Point p(v);
+                if (shard.capacity == 0) {
+                    return p;
+                }
+
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (shard.index.find(key) == shard.index.end()) {
+                    if (shard.lru.size() >= shard.capacity) {
+                        shard.index.erase(shard.lru.back().first);
+                        shard.lru.pop_back();
+                    }
+                    shard.lru.emplace_front(key, p);
+                    shard.index.emplace(key, shard.lru.begin());
+                }
+                return p;
+            }
+
+            Stats GetStats() {
+                Stats stats = {0, 0, 0};
+                for (size_t i = 0; i < num_shards; i++) {
+                    Shard& shard = shards[i];
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    stats.hits += shard.hits;
+                    stats.misses += shard.misses;
+                    stats.size += shard.lru.size();
+                }
+                return stats;
+            }
+        private:
+            const size_t num_shards;
+            std::array<Shard, SHARDS> shards;
+    };
+}
+
+#endif // VOPRF_HASH_CACHE_HPP
@@ -0,0 +1,278 @@
+#include "voprf/voprf.h"
+
+#include "capi.hpp"
+#include "elements.hpp"
+#include "key_store.hpp"
+
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------
+// Key Store
+//----------------------------------------------------------------
+
+#ifdef VOPRF_HAVE_MMAP
+
+namespace {
+    int status_to_error(voprf::KeyStore::Status status) {
+        switch (status) {
+            case voprf::KeyStore::OK:
+                return VOPRF_SUCCESS;
+            case voprf::KeyStore::NOT_FOUND:
+                return VOPRF_ERROR_UNKNOWN_KEY;
+            case voprf::KeyStore::IO_ERROR:
+                return VOPRF_ERROR_IO;
+            case voprf::KeyStore::DUPLICATE_ID:
+                return VOPRF_ERROR_INVALID_ARGUMENT;
+            case voprf::KeyStore::BAD_FORMAT:
+            case voprf::KeyStore::BAD_KEY:
+                break;
+        }
+        return VOPRF_ERROR_DESERIALIZATION;
+    }
+}
+
+extern "C" int voprf_key_store_write(const char* path, const uint64_t* tenant_ids, const voprf_private_key_t* const* keys, size_t n, size_t num_threads) {
+    CHECK_NULL_ARG(path);
+    if (n > 0) {
+        CHECK_NULL_ARG(tenant_ids);
+        CHECK_NULL_ARG(keys);
+    }
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(keys[i]);
+    }
+    VOPRF_TRY
+        std::vector<const voprf::SecretKey*> sks(n);
+        for (size_t i = 0; i < n; i++) {
+            sks[i] = &keys[i]->sk;
+        }
+        voprf::KeyStore::Status status = voprf::KeyStore::Write(path, tenant_ids, sks.data(), n, num_threads);
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_key_store_open(const char* path, size_t cache_capacity, voprf_key_store_t** store) {
+    CHECK_NULL_ARG(path);
+    CHECK_NULL_ARG(store);
+    VOPRF_TRY
+        std::unique_ptr<voprf_key_store_t> new_store(new voprf_key_store_t(path, cache_capacity));
+        voprf::KeyStore::Status status = new_store->store.Open();
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        *store = new_store.release();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_key_store_close(voprf_key_store_t* store) {
+    delete store;
+}
+
+extern "C" int voprf_key_store_size(const voprf_key_store_t* store, size_t* size) {
+    CHECK_NULL_ARG(store);
+    CHECK_NULL_ARG(size);
+    *size = store->store.Size();
+    return VOPRF_SUCCESS;
+}
+
+extern "C" int voprf_key_store_get_private_key(const voprf_key_store_t* store, uint64_t tenant_id, voprf_private_key_t** key) {
+    CHECK_NULL_ARG(store);
+    CHECK_NULL_ARG(key);
+    VOPRF_TRY
+        voprf::SecretKey sk;
+        voprf::KeyStore::Status status = store->store.GetSecretKey(tenant_id, sk);
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        voprf_private_key_t* new_key = new voprf_private_key_t{sk};
+        *key = new_key;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_key_store_get_public_key(const voprf_key_store_t* store, uint64_t tenant_id, voprf_public_key_t** key) {
+    CHECK_NULL_ARG(store);
+    CHECK_NULL_ARG(key);
+    VOPRF_TRY
+        voprf::VerificationKey pk;
+        voprf::KeyStore::Status status = store->store.GetVerificationKey(tenant_id, pk);
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        voprf_public_key_t* new_key = new voprf_public_key_t{pk};
+        *key = new_key;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_key_store_evaluate(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(store);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    VOPRF_TRY
+        std::shared_ptr<const voprf::KeyStore::Context> ctx;
+        voprf::KeyStore::Status status = store->store.GetContext(tenant_id, ctx);
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        voprf_point_t* new_point = new voprf_point_t{ctx->GetPreparedKey().Mul(blinded_point->p)};
+        *evaluated_point = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_key_store_evaluate_into(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(store);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    VOPRF_TRY
+        std::shared_ptr<const voprf::KeyStore::Context> ctx;
+        voprf::KeyStore::Status status = store->store.GetContext(tenant_id, ctx);
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        evaluated_point->p = ctx->GetPreparedKey().Mul(blinded_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_key_store_evaluate_batch(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE_BATCH);
+    CHECK_NULL_ARG(store);
+    VOPRF_TRY
+        std::shared_ptr<const voprf::KeyStore::Context> ctx;
+        voprf::KeyStore::Status status = store->store.GetContext(tenant_id, ctx);
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        return evaluate_batch(ctx->GetPreparedKey(), in, n, out, num_threads);
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_key_store_verify(voprf_key_store_t* store, uint64_t tenant_id, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY);
+    CHECK_NULL_ARG(store);
+    CHECK_NULL_ARG(input_msg);
+    CHECK_NULL_ARG(output_point);
+    CHECK_NULL_ARG(result);
+    VOPRF_TRY
+        std::shared_ptr<const voprf::KeyStore::Context> ctx;
+        voprf::KeyStore::Status status = store->store.GetContext(tenant_id, ctx);
+        if (status != voprf::KeyStore::OK) {
+            return VOPRF_FAIL(status_to_error(status));
+        }
+        *result = voprf::Pairing::Check(voprf::Point::HashToPoint(input_msg, input_msg_len), ctx->GetPreparedVerificationKey(), output_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_key_store_get_cache_stats(voprf_key_store_t* store, uint64_t* hits, uint64_t* misses, size_t* size) {
+    CHECK_NULL_ARG(store);
+    VOPRF_TRY
+        voprf::KeyStore::CacheStats stats = store->store.GetCacheStats();
+        if (hits) {
+            *hits = stats.hits;
+        }
+        if (misses) {
+            *misses = stats.misses;
+        }
+        if (size) {
+            *size = stats.size;
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+#else
+
+extern "C" int voprf_key_store_write(const char* path, const uint64_t* tenant_ids, const voprf_private_key_t* const* keys, size_t n, size_t num_threads) {
+    (void)path;
+    (void)tenant_ids;
+    (void)keys;
+    (void)n;
+    (void)num_threads;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_open(const char* path, size_t cache_capacity, voprf_key_store_t** store) {
+    (void)path;
+    (void)cache_capacity;
+    (void)store;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" void voprf_key_store_close(voprf_key_store_t* store) {
+    (void)store;
+}
+
+extern "C" int voprf_key_store_size(const voprf_key_store_t* store, size_t* size) {
+    (void)store;
+    (void)size;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_get_private_key(const voprf_key_store_t* store, uint64_t tenant_id, voprf_private_key_t** key) {
+    (void)store;
+    (void)tenant_id;
+    (void)key;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_get_public_key(const voprf_key_store_t* store, uint64_t tenant_id, voprf_public_key_t** key) {
+    (void)store;
+    (void)tenant_id;
+    (void)key;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_evaluate(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point) {
+    (void)store;
+    (void)tenant_id;
+    (void)blinded_point;
+    (void)evaluated_point;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_evaluate_into(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point) {
+    (void)store;
+    (void)tenant_id;
+    (void)blinded_point;
+    (void)evaluated_point;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_evaluate_batch(voprf_key_store_t* store, uint64_t tenant_id, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads) {
+    (void)store;
+    (void)tenant_id;
+    (void)in;
+    (void)n;
+    (void)out;
+    (void)num_threads;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_verify(voprf_key_store_t* store, uint64_t tenant_id, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result) {
+    (void)store;
+    (void)tenant_id;
+    (void)input_msg;
+    (void)input_msg_len;
+    (void)output_point;
+    (void)result;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+extern "C" int voprf_key_store_get_cache_stats(voprf_key_store_t* store, uint64_t* hits, uint64_t* misses, size_t* size) {
+    (void)store;
+    (void)hits;
+    (void)misses;
+    (void)size;
+    return VOPRF_FAIL(VOPRF_ERROR_UNSUPPORTED);
+}
+
+#endif // VOPRF_HAVE_MMAP
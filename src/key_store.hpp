@@ -0,0 +1,279 @@
+#ifndef VOPRF_KEY_STORE_HPP
+#define VOPRF_KEY_STORE_HPP
+
+#include "base.hpp"
+#include "elements.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "replacement_file.hpp"
+
+#ifdef VOPRF_HAVE_MMAP
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace voprf {
+    // An on-disk store of per-tenant keys, opened with mmap.
+    //
+    // File layout (all integers little-endian):
+    //
+    //   header:  magic "VOPRFKS1" | u32 version | u32 record size | u64 count
+    //   records: u64 tenant ID | secret key | uncompressed verification key
+    //
+    // Records are fixed-size and sorted by tenant ID, so a lookup is a binary
+    // search over the mapping and opening a store only validates the header.
+    // Keys are deserialized when first used. The store is written by this
+    // library, so its public keys are kept uncompressed (no square root on
+    // load) and read in TRUSTED mode. Prepared contexts for recently used
+    // tenants are kept in a bounded, sharded LRU cache; the pairing
+    // precomputation for a tenant is only done the first time it verifies.
+    class KeyStore {
+        static constexpr size_t HEADER_SIZE = 24;
+        static constexpr size_t ID_SIZE = 8;
+        static constexpr size_t RECORD_SIZE = ID_SIZE + SecretKey::BYTE_SIZE + VerificationKey::UNCOMPRESSED_BYTE_SIZE;
+        static constexpr uint32_t VERSION = 2;
+        static constexpr size_t SHARDS = 16;
+
+        public:
+            enum Status {
+                OK,
+                NOT_FOUND,
+                IO_ERROR,
+                BAD_FORMAT,
+                BAD_KEY,
+                DUPLICATE_ID,
+            };
+
+            // The prepared state for one tenant. The verification side is
+            // prepared lazily by GetPreparedVerificationKey.
+            class Context {
+                public:
+                    Context(const SecretKey& sk, const VerificationKey& pk): key(sk), pk(pk) {}
+
+                    const PreparedKey& GetPreparedKey() const {
+                        return key;
+                    }
+
+                    const PreparedVerificationKey& GetPreparedVerificationKey() const {
+                        std::call_once(prepared_once, [this] {
+                            prepared = PreparedVerificationKey(pk);
+                        });
+                        return prepared;
+                    }
+                private:
+                    PreparedKey key;
+                    VerificationKey pk;
+                    mutable std::once_flag prepared_once;
+                    mutable PreparedVerificationKey prepared;
+            };
+
+            struct CacheStats {
+                uint64_t hits;
+                uint64_t misses;
+                size_t size;
+            };
+
+            // Writes tenant_ids[i] -> keys[i] for i in [0, n) to path in store
+            // format. Verification keys are derived on num_threads threads.
+            static Status Write(const char* path, const uint64_t* tenant_ids, const SecretKey* const* keys, size_t n, size_t num_threads) {
+                vector<size_t> order(n);
+                for (size_t i = 0; i < n; i++) {
+                    order[i] = i;
+                }
+                std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                    return tenant_ids[a] < tenant_ids[b];
+                });
+                for (size_t i = 1; i < n; i++) {
+                    if (tenant_ids[order[i]] == tenant_ids[order[i - 1]]) {
+                        return DUPLICATE_ID;
+                    }
+                }
+
+                vector<uint8_t> buf(HEADER_SIZE + n * RECORD_SIZE);
+                memcpy(buf.data(), "VOPRFKS1", 8);
+                PutLE(buf.data() + 8, VERSION, 4);
+                PutLE(buf.data() + 12, RECORD_SIZE, 4);
+                PutLE(buf.data() + 16, n, 8);
+                Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        const SecretKey& sk = *keys[order[i]];
+                        uint8_t* rec = buf.data() + HEADER_SIZE + i * RECORD_SIZE;
+                        PutLE(rec, tenant_ids[order[i]], ID_SIZE);
+                        sk.Serialize(rec + ID_SIZE, SecretKey::BYTE_SIZE);
+                        sk.GetVerificationKey().Serialize(rec + ID_SIZE + SecretKey::BYTE_SIZE, VerificationKey::UNCOMPRESSED_BYTE_SIZE, UNCOMPRESSED);
+                    }
+                });
+
+                // The store holds secret keys, so it is owner-only, and it is
+                // replaced by rename: an open store keeps mapping the old file
+                // and a failed write leaves the previous store in place.
+                ReplacementFile file(path, 0600);
+                bool written = file.Ok() && file.WriteAt(buf.data(), buf.size(), 0) && file.Commit();
+                SecureWipe(buf.data(), buf.size());
+                return written ? OK : IO_ERROR;
+            }
+
+            // capacity is the maximum number of cached tenant contexts; 0
+            // disables the cache.
+            KeyStore(const char* path, size_t capacity): file(path, MappedFile::RANDOM) {
+                for (size_t i = 0; i < SHARDS; i++) {
+                    shards[i].capacity = capacity / SHARDS + (i < capacity % SHARDS ? 1 : 0);
+                }
+            }
+
+            KeyStore(const KeyStore&) = delete;
+            KeyStore& operator=(const KeyStore&) = delete;
+
+            // Validates the header. Must succeed before any other call.
+            Status Open() {
+                if (!file.ok) {
+                    return IO_ERROR;
+                }
+                if (file.size < HEADER_SIZE || memcmp(file.data, "VOPRFKS1", 8) != 0 ||
+                    GetLE(file.data + 8, 4) != VERSION || GetLE(file.data + 12, 4) != RECORD_SIZE) {
+                    return BAD_FORMAT;
+                }
+                count = GetLE(file.data + 16, 8);
+                if (count > (file.size - HEADER_SIZE) / RECORD_SIZE || file.size != HEADER_SIZE + count * RECORD_SIZE) {
+                    return BAD_FORMAT;
+                }
+                return OK;
+            }
+
+            size_t Size() const {
+                return count;
+            }
+
+            Status GetSecretKey(uint64_t tenant_id, SecretKey& sk) const {
+                const uint8_t* rec = Find(tenant_id);
+                if (!rec) {
+                    return NOT_FOUND;
+                }
+                return sk.Deserialize(rec + ID_SIZE, SecretKey::BYTE_SIZE) == SecretKey::BYTE_SIZE ? OK : BAD_KEY;
+            }
+
+            Status GetVerificationKey(uint64_t tenant_id, VerificationKey& pk) const {
+                const uint8_t* rec = Find(tenant_id);
+                if (!rec) {
+                    return NOT_FOUND;
+                }
+                size_t read = pk.Deserialize(rec + ID_SIZE + SecretKey::BYTE_SIZE, VerificationKey::UNCOMPRESSED_BYTE_SIZE, TRUSTED, UNCOMPRESSED);
+                return read == VerificationKey::UNCOMPRESSED_BYTE_SIZE ? OK : BAD_KEY;
+            }
+
+            // Returns the tenant's prepared context, from the cache if it is
+            // there. On a miss the keys are deserialized and prepared outside
+            // the shard lock; a concurrent miss on the same tenant just
+            // prepares it twice.
+            Status GetContext(uint64_t tenant_id, std::shared_ptr<const Context>& ctx) {
+                Shard& shard = shards[tenant_id % SHARDS];
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    auto it = shard.index.find(tenant_id);
+                    if (it != shard.index.end()) {
+                        shard.hits++;
+                        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                        ctx = it->second->second;
+                        return OK;
+                    }
+                    shard.misses++;
+                }
+
+                const uint8_t* rec = Find(tenant_id);
+                if (!rec) {
+                    return NOT_FOUND;
+                }
+                SecretKey sk;
+                VerificationKey pk;
+                if (sk.Deserialize(rec + ID_SIZE, SecretKey::BYTE_SIZE) != SecretKey::BYTE_SIZE ||
+                    pk.Deserialize(rec + ID_SIZE + SecretKey::BYTE_SIZE, VerificationKey::UNCOMPRESSED_BYTE_SIZE, TRUSTED, UNCOMPRESSED) != VerificationKey::UNCOMPRESSED_BYTE_SIZE) {
+                    return BAD_KEY;
+                }
+                ctx = std::make_shared<const Context>(sk, pk);
+                if (shard.capacity == 0) {
+                    return OK;
+                }
+
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (shard.index.find(tenant_id) == shard.index.end()) {
+                    if (shard.lru.size() >= shard.capacity) {
+                        shard.index.erase(shard.lru.back().first);
+                        shard.lru.pop_back();
+                    }
+                    shard.lru.emplace_front(tenant_id, ctx);
+                    shard.index.emplace(tenant_id, shard.lru.begin());
+                }
+                return OK;
+            }
+
+            CacheStats GetCacheStats() {
+                CacheStats stats = {0, 0, 0};
+                for (auto& shard : shards) {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    stats.hits += shard.hits;
+                    stats.misses += shard.misses;
+                    stats.size += shard.lru.size();
+                }
+                return stats;
+            }
+        private:
+            typedef std::list<std::pair<uint64_t, std::shared_ptr<const Context>>> List;
+
+            struct Shard {
+                std::mutex mutex;
+                List lru; // most recently used first
+                std::unordered_map<uint64_t, List::iterator> index;
+                size_t capacity = 0;
+                uint64_t hits = 0;
+                uint64_t misses = 0;
+            };
+
+            static void PutLE(uint8_t* p, uint64_t v, size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    p[i] = static_cast<uint8_t>(v >> (8 * i));
+                }
+            }
+
+            static uint64_t GetLE(const uint8_t* p, size_t n) {
+                uint64_t v = 0;
+                for (size_t i = n; i > 0; i--) {
+                    v = (v << 8) | p[i - 1];
+                }
+                return v;
+            }
+
+            // Binary search over the mapped records. Only the pages on the
+            // search path are touched.
+            const uint8_t* Find(uint64_t tenant_id) const {
+                const uint8_t* records = file.data + HEADER_SIZE;
+                size_t lo = 0;
+                size_t hi = count;
+                while (lo < hi) {
+                    size_t mid = lo + (hi - lo) / 2;
+                    uint64_t id = GetLE(records + mid * RECORD_SIZE, ID_SIZE);
+                    if (id == tenant_id) {
+                        return records + mid * RECORD_SIZE;
+                    }
+                    if (id < tenant_id) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                return nullptr;
+            }
+
+            MappedFile file;
+            size_t count = 0;
+            std::array<Shard, SHARDS> shards;
+    };
+}
+
+#endif // VOPRF_HAVE_MMAP
+
+#endif // VOPRF_KEY_STORE_HPP
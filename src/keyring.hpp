@@ -0,0 +1,179 @@
+#ifndef VOPRF_KEYRING_HPP
+#define VOPRF_KEYRING_HPP
+
+#include "base.hpp"
+#include "elements.hpp"
+#include "epoch.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace voprf {
+    // A set of server keys indexed by key ID, for serving several key
+    // generations at once during rotation.
+    //
+    // Each key is prepared once when it is added (PreparedKey for
+    // evaluation, PreparedVerificationKey for verification). The lookup
+    // table is immutable: Add and Retire copy it, modify the copy and
+    // publish it with an atomic pointer exchange. A Lookup reads the current
+    // table inside an epoch guard (see epoch.hpp), so it takes no lock and
+    // writes no shared cache line. A superseded table, and the entry a
+    // Retire removed, is reclaimed by a later Add or Retire once every
+    // lookup that could still see it has finished; destroying the entry's
+    // PreparedKey wipes the secret.
+    class Keyring {
+        public:
+            struct Entry {
+                uint64_t id;
+                PreparedKey key;
+                PreparedVerificationKey pk;
+            };
+
+            // The entry for one key ID, or none. The entry stays valid for
+            // the lifetime of the Lookup, even if the key is retired in the
+            // meantime, so a Lookup should not outlive the call it serves.
+            class Lookup {
+                public:
+                    Lookup(const Keyring& keyring, uint64_t id) {
+                        const Table* t = keyring.table.load(std::memory_order_seq_cst);
+                        auto it = t->find(id);
+                        entry = it == t->end() ? nullptr : it->second;
+                    }
+
+                    Lookup(const Lookup&) = delete;
+                    Lookup& operator=(const Lookup&) = delete;
+
+                    explicit operator bool() const {
+                        return entry != nullptr;
+                    }
+
+                    const Entry* operator->() const {
+                        return entry;
+                    }
+                private:
+                    // Declared first, so the guard is entered before the
+                    // table is read.
+                    epoch::Guard guard;
+                    const Entry* entry;
+            };
+
+            // A compact identifier for a verification key: the first eight
+            // bytes (little-endian) of a hash of its serialized form. Clients
+            // can compute it from the public key alone.
+            static uint64_t KeyId(const VerificationKey& pk) {
+                uint8_t buf[VerificationKey::BYTE_SIZE];
+                size_t len = pk.Serialize(buf, sizeof(buf));
+                mcl::bn::Fp t;
+                t.setHashOf(buf, len);
+                uint8_t digest[Point::BYTE_SIZE];
+                memset(digest, 0, sizeof(digest));
+                t.serialize(digest, sizeof(digest));
+                uint64_t id = 0;
+                for (int i = 7; i >= 0; i--) {
+                    id = (id << 8) | digest[i];
+                }
+                return id;
+            }
+
+            Keyring(): table(new Table()) {}
+
+            // No lookup may be in progress.
+            ~Keyring() {
+                for (const Retired& r : retired) {
+                    delete r.table;
+                    delete r.entry;
+                }
+                const Table* t = table.load(std::memory_order_relaxed);
+                for (const auto& kv : *t) {
+                    delete kv.second;
+                }
+                delete t;
+            }
+
+            Keyring(const Keyring&) = delete;
+            Keyring& operator=(const Keyring&) = delete;
+
+            // Adds sk and returns its key ID. Adding a key that is already
+            // present is a no-op. The precomputation happens before the
+            // write lock is taken.
+            uint64_t Add(const SecretKey& sk) {
+                VerificationKey pk = sk.GetVerificationKey();
+                std::unique_ptr<const Entry> entry(new Entry{KeyId(pk), PreparedKey(sk), PreparedVerificationKey(pk)});
+                const uint64_t id = entry->id;
+
+                std::lock_guard<std::mutex> lock(write_mutex);
+                const Table* current = table.load(std::memory_order_relaxed);
+                if (current->count(id)) {
+                    return id;
+                }
+                std::unique_ptr<Table> next(new Table(*current));
+                next->emplace(id, entry.get());
+                Publish(std::move(next), nullptr);
+                entry.release();
+                return id;
+            }
+
+            // Removes id from the lookup table. Returns false if it was not
+            // present.
+            bool Retire(uint64_t id) {
+                std::lock_guard<std::mutex> lock(write_mutex);
+                const Table* current = table.load(std::memory_order_relaxed);
+                auto it = current->find(id);
+                if (it == current->end()) {
+                    return false;
+                }
+                const Entry* gone = it->second;
+                std::unique_ptr<Table> next(new Table(*current));
+                next->erase(id);
+                Publish(std::move(next), gone);
+                return true;
+            }
+
+            size_t Size() const {
+                epoch::Guard guard;
+                return table.load(std::memory_order_seq_cst)->size();
+            }
+        private:
+            typedef std::unordered_map<uint64_t, const Entry*> Table;
+
+            // A superseded table, with the entry it alone still referenced
+            // if it was replaced by a Retire, and the epoch tag after which
+            // no lookup can see either.
+            struct Retired {
+                uint64_t tag;
+                const Table* table;
+                const Entry* entry;
+            };
+
+            // Installs next and retires the table it replaces. Called with
+            // write_mutex held.
+            void Publish(std::unique_ptr<Table> next, const Entry* gone) {
+                retired.reserve(retired.size() + 1);
+                const Table* old = table.exchange(next.release(), std::memory_order_seq_cst);
+                retired.push_back(Retired{epoch::Advance(), old, gone});
+
+                uint64_t oldest = epoch::Oldest();
+                size_t kept = 0;
+                for (const Retired& r : retired) {
+                    if (r.tag < oldest) {
+                        delete r.table;
+                        delete r.entry;
+                    } else {
+                        retired[kept++] = r;
+                    }
+                }
+                retired.resize(kept);
+            }
+
+            std::atomic<const Table*> table;
+            std::mutex write_mutex;
+            // Guarded by write_mutex.
+            std::vector<Retired> retired;
+    };
+}
+
+#endif // VOPRF_KEYRING_HPP
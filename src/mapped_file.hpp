@@ -0,0 +1,82 @@
+#ifndef VOPRF_MAPPED_FILE_HPP
+#define VOPRF_MAPPED_FILE_HPP
+
+#include "base.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VOPRF_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef VOPRF_HAVE_MMAP
+
+namespace voprf {
+    // A read-only memory mapping of a whole file.
+    class MappedFile {
+        public:
+            enum Access {
+                SEQUENTIAL,
+                RANDOM,
+            };
+
+            MappedFile(const char* path, Access access) {
+                fd = open(path, O_RDONLY);
+                if (fd < 0) {
+                    return;
+                }
+                struct stat st;
+                if (fstat(fd, &st) != 0) {
+                    return;
+                }
+                size = static_cast<size_t>(st.st_size);
+                if (size == 0) {
+                    ok = true;
+                    return;
+                }
+                void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    return;
+                }
+                data = static_cast<const uint8_t*>(p);
+                madvise(const_cast<uint8_t*>(data), size, access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+                ok = true;
+            }
+
+            ~MappedFile() {
+                if (data) {
+                    munmap(const_cast<uint8_t*>(data), size);
+                }
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            // Drops the pages below `end` from this process's working set
+            // once they have been consumed.
+            void Release(size_t end) {
+                long page = sysconf(_SC_PAGESIZE);
+                size_t aligned = page > 0 ? end - end % static_cast<size_t>(page) : 0;
+                if (data && aligned > released) {
+                    madvise(const_cast<uint8_t*>(data) + released, aligned - released, MADV_DONTNEED);
+                    released = aligned;
+                }
+            }
+
+            bool ok = false;
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+        private:
+            int fd = -1;
+            size_t released = 0;
+    };
+}
+
+#endif // VOPRF_HAVE_MMAP
+
+#endif // VOPRF_MAPPED_FILE_HPP
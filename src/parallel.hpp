@@ -0,0 +1,80 @@
+#ifndef VOPRF_PARALLEL_HPP
+#define VOPRF_PARALLEL_HPP
+
+#include "base.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace voprf {
+    class Parallel {
+        public:
+            // Resolves a caller-supplied thread count: 0 means "one per core".
+            static size_t ThreadCount(size_t requested) {
+                if (requested != 0) {
+                    return requested;
+                }
+                size_t hw = std::thread::hardware_concurrency();
+                return hw == 0 ? 1 : hw;
+            }
+
+            // Splits [0, n) into contiguous chunks and calls fn(begin, end) for
+            // each chunk on its own thread. The calling thread runs the first
+            // chunk itself. The first exception thrown by any chunk is rethrown
+            // once every thread has been joined.
+            template <typename F>
+            static void For(size_t n, size_t threads, F fn) {
+                threads = std::min(ThreadCount(threads), n);
+                if (threads <= 1) {
+                    if (n > 0) {
+                        fn(size_t(0), n);
+                    }
+                    return;
+                }
+
+                std::exception_ptr error;
+                std::mutex error_mutex;
+                auto run = [&](size_t begin, size_t end) {
+                    try {
+                        fn(begin, end);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(error_mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                };
+
+                size_t chunk = n / threads;
+                size_t extra = n % threads;
+                vector<std::thread> workers;
+                workers.reserve(threads - 1);
+
+                size_t first_end = chunk + (extra > 0 ? 1 : 0);
+                size_t begin = first_end;
+                for (size_t t = 1; t < threads; t++) {
+                    size_t end = begin + chunk + (t < extra ? 1 : 0);
+                    try {
+                        workers.emplace_back(run, begin, end);
+                    } catch (const std::system_error&) {
+                        // Out of threads: do this chunk on the caller instead.
+                        run(begin, end);
+                    }
+                    begin = end;
+                }
+                run(0, first_end);
+
+                for (auto& w : workers) {
+                    w.join();
+                }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+    };
+}
+
+#endif // VOPRF_PARALLEL_HPP
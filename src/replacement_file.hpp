@@ -0,0 +1,88 @@
+#ifndef VOPRF_REPLACEMENT_FILE_HPP
+#define VOPRF_REPLACEMENT_FILE_HPP
+
+#include "base.hpp"
+#include "mapped_file.hpp"
+
+#ifdef VOPRF_HAVE_MMAP
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+namespace voprf {
+    // A file that replaces `path` as a whole. It is written under a temporary
+    // name in the same directory and renamed over `path` by Commit(), so
+    // anyone opening or mapping `path` sees either the previous file or the
+    // complete new one, never a truncated or partial write. The temporary is
+    // created exclusively with owner-only permissions and switched to `mode`
+    // just before the rename. Destroying the object without a successful
+    // Commit() removes the temporary and leaves `path` untouched.
+    class ReplacementFile {
+        public:
+            ReplacementFile(const char* path, mode_t mode): path(path), tmp(this->path + ".tmpXXXXXX"), mode(mode) {
+                fd = mkstemp(&tmp[0]);
+                created = fd >= 0;
+            }
+
+            ~ReplacementFile() {
+                if (fd >= 0) {
+                    close(fd);
+                }
+                if (created && !committed) {
+                    unlink(tmp.c_str());
+                }
+            }
+
+            ReplacementFile(const ReplacementFile&) = delete;
+            ReplacementFile& operator=(const ReplacementFile&) = delete;
+
+            bool Ok() const {
+                return fd >= 0;
+            }
+
+            // Positional writes, so chunks may be written out of order and
+            // from several threads.
+            bool WriteAt(const uint8_t* buf, size_t len, size_t offset) const {
+                while (len > 0) {
+                    ssize_t n = pwrite(fd, buf, len, static_cast<off_t>(offset));
+                    if (n < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        return false;
+                    }
+                    buf += n;
+                    len -= static_cast<size_t>(n);
+                    offset += static_cast<size_t>(n);
+                }
+                return true;
+            }
+
+            // Flushes the contents to disk and renames the file into place.
+            // Every write must have finished.
+            bool Commit() {
+                if (fd < 0 || fchmod(fd, mode) != 0 || fsync(fd) != 0) {
+                    return false;
+                }
+                int status = close(fd);
+                fd = -1;
+                if (status != 0 || std::rename(tmp.c_str(), path.c_str()) != 0) {
+                    return false;
+                }
+                committed = true;
+                return true;
+            }
+        private:
+            std::string path;
+            std::string tmp;
+            mode_t mode;
+            int fd = -1;
+            bool created = false;
+            bool committed = false;
+    };
+}
+
+#endif // VOPRF_HAVE_MMAP
+
+#endif // VOPRF_REPLACEMENT_FILE_HPP
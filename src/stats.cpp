@@ -0,0 +1,158 @@
+#include "stats.hpp"
+
+#ifdef VOPRF_ENABLE_STATS
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace voprf {
+    namespace stats {
+        namespace {
+            // One thread's counters. Only the owning thread writes, so each
+            // update is a relaxed load and store; readers may see a value
+            // that is at most one update stale.
+            struct Counters {
+                std::atomic<uint64_t> calls[VOPRF_STATS_OP_COUNT] = {};
+                std::atomic<uint64_t> total_ns[VOPRF_STATS_OP_COUNT] = {};
+                std::atomic<uint64_t> buckets[VOPRF_STATS_OP_COUNT][VOPRF_STATS_LATENCY_BUCKETS] = {};
+                std::atomic<uint64_t> errors[VOPRF_STATS_ERROR_CODES] = {};
+                std::atomic<uint64_t> bytes_serialized{0};
+                std::atomic<uint64_t> bytes_deserialized{0};
+            };
+
+            void Bump(std::atomic<uint64_t>& c, uint64_t v) {
+                c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+            }
+
+            uint64_t Read(const std::atomic<uint64_t>& c) {
+                return c.load(std::memory_order_relaxed);
+            }
+
+            // Adds every counter of `from` into `to`. Used to fold exited
+            // threads into the retired totals and to build snapshots.
+            void Accumulate(Counters& to, const Counters& from) {
+                for (int op = 0; op < VOPRF_STATS_OP_COUNT; op++) {
+                    Bump(to.calls[op], Read(from.calls[op]));
+                    Bump(to.total_ns[op], Read(from.total_ns[op]));
+                    for (int b = 0; b < VOPRF_STATS_LATENCY_BUCKETS; b++) {
+                        Bump(to.buckets[op][b], Read(from.buckets[op][b]));
+                    }
+                }
+                for (int e = 0; e < VOPRF_STATS_ERROR_CODES; e++) {
+                    Bump(to.errors[e], Read(from.errors[e]));
+                }
+                Bump(to.bytes_serialized, Read(from.bytes_serialized));
+                Bump(to.bytes_deserialized, Read(from.bytes_deserialized));
+            }
+
+            class Registry {
+                public:
+                    // Deliberately leaked so that thread-local shards can still
+                    // retire into it during static destruction.
+                    static Registry& Get() {
+                        static Registry* registry = new Registry();
+                        return *registry;
+                    }
+
+                    void Add(Counters* c) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        live.push_back(c);
+                    }
+
+                    void Retire(Counters* c) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        Accumulate(retired, *c);
+                        for (size_t i = 0; i < live.size(); i++) {
+                            if (live[i] == c) {
+                                live[i] = live.back();
+                                live.pop_back();
+                                break;
+                            }
+                        }
+                    }
+
+                    void Sum(Counters& out) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        Accumulate(out, retired);
+                        for (Counters* c : live) {
+                            Accumulate(out, *c);
+                        }
+                    }
+                private:
+                    std::mutex mutex;
+                    std::vector<Counters*> live;
+                    Counters retired;
+            };
+
+            struct Shard {
+                Counters counters;
+
+                Shard() {
+                    Registry::Get().Add(&counters);
+                }
+
+                ~Shard() {
+                    Registry::Get().Retire(&counters);
+                }
+            };
+
+            Counters& Local() {
+                thread_local Shard shard;
+                return shard.counters;
+            }
+
+            // Bucket b holds latencies in [2^b, 2^(b+1)) ns; bucket 0 also
+            // holds 0 and the last bucket is open-ended.
+            int Bucket(uint64_t ns) {
+                int b = 0;
+                while (ns > 1 && b < VOPRF_STATS_LATENCY_BUCKETS - 1) {
+                    ns >>= 1;
+                    b++;
+                }
+                return b;
+            }
+        }
+
+        void RecordCall(voprf_stats_op op, uint64_t latency_ns) {
+            Counters& c = Local();
+            Bump(c.calls[op], 1);
+            Bump(c.total_ns[op], latency_ns);
+            Bump(c.buckets[op][Bucket(latency_ns)], 1);
+        }
+
+        void RecordError(int code) {
+            int idx = code < 0 ? -code : 0;
+            if (idx >= VOPRF_STATS_ERROR_CODES) {
+                idx = VOPRF_STATS_ERROR_CODES - 1;
+            }
+            Bump(Local().errors[idx], 1);
+        }
+
+        void RecordBytes(Direction dir, size_t n) {
+            Counters& c = Local();
+            Bump(dir == SERIALIZED ? c.bytes_serialized : c.bytes_deserialized, n);
+        }
+
+        void Snapshot(voprf_stats_t* out) {
+            Counters sum;
+            Registry::Get().Sum(sum);
+
+            out->enabled = true;
+            for (int op = 0; op < VOPRF_STATS_OP_COUNT; op++) {
+                out->ops[op].calls = Read(sum.calls[op]);
+                out->ops[op].total_ns = Read(sum.total_ns[op]);
+                for (int b = 0; b < VOPRF_STATS_LATENCY_BUCKETS; b++) {
+                    out->ops[op].latency_buckets[b] = Read(sum.buckets[op][b]);
+                }
+            }
+            for (int e = 0; e < VOPRF_STATS_ERROR_CODES; e++) {
+                out->errors[e] = Read(sum.errors[e]);
+            }
+            out->bytes_serialized = Read(sum.bytes_serialized);
+            out->bytes_deserialized = Read(sum.bytes_deserialized);
+        }
+    }
+}
+
+#endif // VOPRF_ENABLE_STATS
@@ -0,0 +1,76 @@
+#ifndef VOPRF_STATS_HPP
+#define VOPRF_STATS_HPP
+
+#include "voprf/voprf.h"
+
+#include <chrono>
+
+// Hot-path instrumentation. Every hook below expands to nothing unless the
+// library is built with VOPRF_ENABLE_STATS, so the default build pays nothing
+// for it.
+//
+//   VOPRF_STATS_TIMER(op)         counts a call to `op` and records its latency
+//                                 in a log-bucketed histogram when the
+//                                 enclosing scope exits.
+//   VOPRF_STATS_BYTES(dir, n)     adds n to the serialized/deserialized byte
+//                                 counters (dir is SERIALIZED or DESERIALIZED).
+//   VOPRF_FAIL(code)              records an error status and evaluates to it,
+//                                 for use as `return VOPRF_FAIL(...)`.
+//
+// Counters are kept per thread and written only by their owning thread, so
+// recording never takes a lock or issues an atomic read-modify-write. A
+// snapshot sums every live thread's counters plus those of exited threads.
+
+#ifdef VOPRF_ENABLE_STATS
+
+namespace voprf {
+    namespace stats {
+        enum Direction {
+            SERIALIZED,
+            DESERIALIZED,
+        };
+
+        void RecordCall(voprf_stats_op op, uint64_t latency_ns);
+        void RecordError(int code);
+        void RecordBytes(Direction dir, size_t n);
+        void Snapshot(voprf_stats_t* out);
+
+        class Timer {
+            public:
+                explicit Timer(voprf_stats_op op): op(op), start(std::chrono::steady_clock::now()) {}
+
+                ~Timer() {
+                    auto elapsed = std::chrono::steady_clock::now() - start;
+                    RecordCall(op, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                }
+
+                Timer(const Timer&) = delete;
+                Timer& operator=(const Timer&) = delete;
+            private:
+                voprf_stats_op op;
+                std::chrono::steady_clock::time_point start;
+        };
+
+        inline int Fail(int code) {
+            RecordError(code);
+            return code;
+        }
+    }
+}
+
+#define VOPRF_STATS_CONCAT_(a, b) a##b
+#define VOPRF_STATS_CONCAT(a, b) VOPRF_STATS_CONCAT_(a, b)
+#define VOPRF_STATS_TIMER(op) \
+    voprf::stats::Timer VOPRF_STATS_CONCAT(voprf_stats_timer_, __LINE__)(op)
+#define VOPRF_STATS_BYTES(dir, n) voprf::stats::RecordBytes(voprf::stats::dir, (n))
+#define VOPRF_FAIL(code) voprf::stats::Fail(code)
+
+#else
+
+#define VOPRF_STATS_TIMER(op) ((void)0)
+#define VOPRF_STATS_BYTES(dir, n) ((void)0)
+#define VOPRF_FAIL(code) (code)
+
+#endif // VOPRF_ENABLE_STATS
+
+#endif // VOPRF_STATS_HPP
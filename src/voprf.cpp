@@ -1,66 +1,17 @@
 #include "voprf/voprf.h"
 
 // Include your internal C++ headers for the cryptographic elements.
+#include "capi.hpp"
 #include "elements.hpp"
+#include "batch_verify.hpp"
+#include "parallel.hpp"
 
-#include <new> // For std::bad_alloc
+#include <atomic>
+#include <memory>
+#include <algorithm>
 #include <vector>
 #include <string>
 
-//----------------------------------------------------------------
-// Internal Error Codes
-//----------------------------------------------------------------
-enum voprf_error_code {
-    VOPRF_SUCCESS = 0,
-    VOPRF_ERROR_NULL_ARG = -1,
-    VOPRF_ERROR_MALLOC = -2,
-    VOPRF_ERROR_SERIALIZATION = -3,
-    VOPRF_ERROR_DESERIALIZATION = -4,
-    VOPRF_ERROR_INVALID_BUFFER_SIZE = -5,
-    VOPRF_ERROR_CPP_EXCEPTION = -10,
-};
-
-//----------------------------------------------------------------
-// Opaque Struct Definitions
-//----------------------------------------------------------------
-
-// These structs wrap the C++ objects. The user of the C API
-// only ever sees a pointer to these, never their contents.
-struct voprf_private_key_t {
-    voprf::SecretKey sk;
-};
-
-struct voprf_public_key_t {
-    voprf::VerificationKey pk;
-};
-
-struct voprf_point_t {
-    voprf::Point p;
-};
-
-
-//----------------------------------------------------------------
-// Helper Macros
-//----------------------------------------------------------------
-
-// Macro to safely handle C++ exceptions at the API boundary.
-#define VOPRF_TRY \
-    try {
-
-#define VOPRF_CATCH                                        \
-    } catch (const std::bad_alloc&) {                      \
-        return VOPRF_ERROR_MALLOC;                         \
-    } catch (const std::exception&) {                      \
-        return VOPRF_ERROR_CPP_EXCEPTION;                  \
-    } catch (...) {                                        \
-        return VOPRF_ERROR_CPP_EXCEPTION;                  \
-    }
-
-// Macro for basic NULL argument checks.
-#define CHECK_NULL_ARG(arg) \
-    if (!(arg)) { return VOPRF_ERROR_NULL_ARG; }
-
-
 //----------------------------------------------------------------
 // Global Library Initialization
 //----------------------------------------------------------------
@@ -105,32 +56,40 @@ extern "C" int voprf_private_key_get_byte_size(const voprf_private_key_t* key, s
     CHECK_NULL_ARG(key);
     CHECK_NULL_ARG(size);
     VOPRF_TRY
-        *size = key->sk.ToBytes().size();
+        *size = voprf::SecretKey::BYTE_SIZE;
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
 
 extern "C" int voprf_private_key_to_bytes(const voprf_private_key_t* key, uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_SERIALIZE);
     CHECK_NULL_ARG(key);
     CHECK_NULL_ARG(buffer);
     VOPRF_TRY
-        std::vector<uint8_t> bytes = key->sk.ToBytes();
-        if (bytes.size() > buffer_len) {
-            return VOPRF_ERROR_INVALID_BUFFER_SIZE;
+        if (buffer_len < voprf::SecretKey::BYTE_SIZE) {
+            return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
         }
-        memcpy(buffer, bytes.data(), bytes.size());
+        size_t written = key->sk.Serialize(buffer, buffer_len);
+        if (written == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(SERIALIZED, written);
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
 
 extern "C" int voprf_private_key_from_bytes(voprf_private_key_t** key, const uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
     CHECK_NULL_ARG(key);
     CHECK_NULL_ARG(buffer);
     VOPRF_TRY
-        std::vector<uint8_t> bytes(buffer, buffer + buffer_len);
-        voprf_private_key_t* new_key = new voprf_private_key_t();
-        new_key->sk = voprf::SecretKey::FromBytes(bytes);
-        *key = new_key;
+        voprf::SecretKey sk;
+        size_t read = sk.Deserialize(buffer, buffer_len);
+        if (read == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, read);
+        *key = new voprf_private_key_t{sk};
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
@@ -147,32 +106,40 @@ extern "C" int voprf_public_key_get_byte_size(const voprf_public_key_t* key, siz
     CHECK_NULL_ARG(key);
     CHECK_NULL_ARG(size);
     VOPRF_TRY
-        *size = key->pk.ToBytes().size();
+        *size = voprf::VerificationKey::BYTE_SIZE;
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
 
 extern "C" int voprf_public_key_to_bytes(const voprf_public_key_t* key, uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_SERIALIZE);
     CHECK_NULL_ARG(key);
     CHECK_NULL_ARG(buffer);
     VOPRF_TRY
-        std::vector<uint8_t> bytes = key->pk.ToBytes();
-        if (bytes.size() > buffer_len) {
-            return VOPRF_ERROR_INVALID_BUFFER_SIZE;
+        if (buffer_len < voprf::VerificationKey::BYTE_SIZE) {
+            return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
         }
-        memcpy(buffer, bytes.data(), bytes.size());
+        size_t written = key->pk.Serialize(buffer, buffer_len);
+        if (written == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(SERIALIZED, written);
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
 
 extern "C" int voprf_public_key_from_bytes(voprf_public_key_t** key, const uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
     CHECK_NULL_ARG(key);
     CHECK_NULL_ARG(buffer);
     VOPRF_TRY
-        std::vector<uint8_t> bytes(buffer, buffer + buffer_len);
-        voprf_public_key_t* new_key = new voprf_public_key_t();
-        new_key->pk = voprf::VerificationKey::FromBytes(bytes);
-        *key = new_key;
+        voprf::VerificationKey pk;
+        size_t read = pk.Deserialize(buffer, buffer_len);
+        if (read == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, read);
+        *key = new voprf_public_key_t{pk};
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
@@ -189,32 +156,40 @@ extern "C" int voprf_point_get_byte_size(const voprf_point_t* point, size_t* siz
     CHECK_NULL_ARG(point);
     CHECK_NULL_ARG(size);
     VOPRF_TRY
-        *size = point->p.ToBytes().size();
+        *size = voprf::Point::BYTE_SIZE;
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
 
 extern "C" int voprf_point_to_bytes(const voprf_point_t* point, uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_SERIALIZE);
     CHECK_NULL_ARG(point);
     CHECK_NULL_ARG(buffer);
     VOPRF_TRY
-        std::vector<uint8_t> bytes = point->p.ToBytes();
-        if (bytes.size() > buffer_len) {
-            return VOPRF_ERROR_INVALID_BUFFER_SIZE;
+        if (buffer_len < voprf::Point::BYTE_SIZE) {
+            return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+        }
+        size_t written = point->p.Serialize(buffer, buffer_len);
+        if (written == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
         }
-        memcpy(buffer, bytes.data(), bytes.size());
+        VOPRF_STATS_BYTES(SERIALIZED, written);
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
 
 extern "C" int voprf_point_from_bytes(voprf_point_t** point, const uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
     CHECK_NULL_ARG(point);
     CHECK_NULL_ARG(buffer);
     VOPRF_TRY
-        std::vector<uint8_t> bytes(buffer, buffer + buffer_len);
-        voprf_point_t* new_point = new voprf_point_t();
-        new_point->p = voprf::Point::FromBytes(bytes);
-        *point = new_point;
+        voprf::Point p;
+        size_t read = p.Deserialize(buffer, buffer_len);
+        if (read == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, read);
+        *point = new voprf_point_t{p};
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
@@ -229,20 +204,113 @@ extern "C" int voprf_point_equal(const voprf_point_t* p1, const voprf_point_t* p
     VOPRF_CATCH
 }
 
+//----------------------------------------------------------------
+// Internal Helpers
+//----------------------------------------------------------------
+
+// Evaluates a batch into existing output objects. Arguments must already
+// have been checked.
+static void evaluate_batch_into(const voprf::PreparedKey& key, const voprf_point_t* const* in, size_t n, voprf_point_t* const* out, size_t num_threads) {
+    voprf::Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            out[i]->p = key.Mul(in[i]->p);
+        }
+    });
+}
+
+// Shared body of the batch evaluate entry points. Allocates every output up
+// front so that a failure part-way through can release them all.
+int evaluate_batch(const voprf::PreparedKey& key, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads) {
+    if (n == 0) {
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(in);
+    CHECK_NULL_ARG(out);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(in[i]);
+    }
+    std::fill(out, out + n, nullptr);
+    VOPRF_TRY
+        try {
+            for (size_t i = 0; i < n; i++) {
+                out[i] = new voprf_point_t();
+            }
+            evaluate_batch_into(key, in, n, out, num_threads);
+        } catch (...) {
+            for (size_t i = 0; i < n; i++) {
+                delete out[i];
+                out[i] = nullptr;
+            }
+            throw;
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+// Shared body of the batch verify entry points.
+static int verify_batch(const voprf::PreparedVerificationKey& pk, const uint8_t* const* input_msgs, const size_t* input_msg_lens, const voprf_point_t* const* output_points, size_t n, bool* results, bool* all_valid, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY_BATCH);
+    CHECK_NULL_ARG(all_valid);
+    if (n == 0) {
+        *all_valid = true;
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(input_msgs);
+    CHECK_NULL_ARG(input_msg_lens);
+    CHECK_NULL_ARG(output_points);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(input_msgs[i]);
+        CHECK_NULL_ARG(output_points[i]);
+    }
+    VOPRF_TRY
+        std::vector<mcl::bn::G1> hashed(n);
+        std::vector<mcl::bn::G1> outputs(n);
+        voprf::Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                hashed[i] = voprf::Point::HashToPoint(input_msgs[i], input_msg_lens[i]).GetG1();
+                outputs[i] = output_points[i]->p.GetG1();
+            }
+        });
+
+        voprf::BatchVerifier verifier(pk, std::move(hashed), std::move(outputs));
+        *all_valid = verifier.Run(results);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
 //----------------------------------------------------------------
 // Core VOPRF Operations
 //----------------------------------------------------------------
 
+extern "C" int voprf_hash_to_point_batch(const uint8_t* const* msgs, const size_t* msg_lens, size_t n, voprf_point_t* points, size_t num_threads) {
+    if (n == 0) {
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(msgs);
+    CHECK_NULL_ARG(msg_lens);
+    CHECK_NULL_ARG(points);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(msgs[i]);
+    }
+    VOPRF_TRY
+        voprf::Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                points[i].p = voprf::Point::HashToPoint(msgs[i], msg_lens[i]);
+            }
+        });
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
 extern "C" int voprf_blind(const uint8_t* msg, size_t msg_len, voprf_private_key_t** blinding_factor, voprf_point_t** blinded_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_BLIND);
     CHECK_NULL_ARG(msg);
     CHECK_NULL_ARG(blinding_factor);
     CHECK_NULL_ARG(blinded_point);
     VOPRF_TRY
-        std::string msg_str(reinterpret_cast<const char*>(msg), msg_len);
-        
         // Logic from VOPRF::Blind
         voprf::SecretKey r = voprf::SecretKey::Keygen();
-        voprf::Point x = voprf::Point::Mul(voprf::Point::HashToPoint(msg_str), r);
+        voprf::Point x = voprf::Point::Mul(voprf::Point::HashToPoint(msg, msg_len), r);
 
         voprf_private_key_t* r_out = new voprf_private_key_t{r};
         voprf_point_t* x_out = new voprf_point_t{x};
@@ -254,7 +322,34 @@ extern "C" int voprf_blind(const uint8_t* msg, size_t msg_len, voprf_private_key
     VOPRF_CATCH
 }
 
+extern "C" int voprf_blind_batch(const uint8_t* const* msgs, const size_t* msg_lens, size_t n, voprf_private_key_t* blinding_factors, voprf_point_t* blinded_points, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_BLIND_BATCH);
+    if (n == 0) {
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(msgs);
+    CHECK_NULL_ARG(msg_lens);
+    CHECK_NULL_ARG(blinding_factors);
+    CHECK_NULL_ARG(blinded_points);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(msgs[i]);
+    }
+    VOPRF_TRY
+        // Draw randomness on this thread; only hashing and blinding fan out.
+        for (size_t i = 0; i < n; i++) {
+            blinding_factors[i].sk = voprf::SecretKey::Keygen();
+        }
+        voprf::Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                blinded_points[i].p = voprf::Point::Mul(voprf::Point::HashToPoint(msgs[i], msg_lens[i]), blinding_factors[i].sk);
+            }
+        });
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
 extern "C" int voprf_evaluate(const voprf_private_key_t* sk, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
     CHECK_NULL_ARG(sk);
     CHECK_NULL_ARG(blinded_point);
     CHECK_NULL_ARG(evaluated_point);
@@ -268,7 +363,18 @@ extern "C" int voprf_evaluate(const voprf_private_key_t* sk, const voprf_point_t
     VOPRF_CATCH
 }
 
+extern "C" int voprf_evaluate_batch(const voprf_private_key_t* sk, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE_BATCH);
+    CHECK_NULL_ARG(sk);
+    VOPRF_TRY
+        // Prepare the scalar once and share it across every worker.
+        voprf::PreparedKey key(sk->sk);
+        return evaluate_batch(key, in, n, out, num_threads);
+    VOPRF_CATCH
+}
+
 extern "C" int voprf_unblind(const voprf_point_t* evaluated_point, const voprf_private_key_t* blinding_factor, voprf_point_t** final_output) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_UNBLIND);
     CHECK_NULL_ARG(evaluated_point);
     CHECK_NULL_ARG(blinding_factor);
     CHECK_NULL_ARG(final_output);
@@ -283,19 +389,1007 @@ extern "C" int voprf_unblind(const voprf_point_t* evaluated_point, const voprf_p
     VOPRF_CATCH
 }
 
+extern "C" int voprf_unblind_batch(const voprf_point_t* evaluated_points, const voprf_private_key_t* blinding_factors, size_t n, voprf_point_t* final_outputs, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_UNBLIND_BATCH);
+    if (n == 0) {
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(evaluated_points);
+    CHECK_NULL_ARG(blinding_factors);
+    CHECK_NULL_ARG(final_outputs);
+    VOPRF_TRY
+        std::vector<mcl::bn::Fr> r_inv(n);
+        for (size_t i = 0; i < n; i++) {
+            r_inv[i] = blinding_factors[i].sk.GetFr();
+        }
+        if (!voprf::SecretKey::InverseBatch(r_inv)) {
+            return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+        }
+        voprf::Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                final_outputs[i].p = voprf::Point::Mul(evaluated_points[i].p, voprf::SecretKey(r_inv[i]));
+            }
+        });
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
 extern "C" int voprf_verify(const voprf_public_key_t* pk, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY);
     CHECK_NULL_ARG(pk);
     CHECK_NULL_ARG(input_msg);
     CHECK_NULL_ARG(output_point);
     CHECK_NULL_ARG(result);
     VOPRF_TRY
-        std::string msg_str(reinterpret_cast<const char*>(input_msg), input_msg_len);
+        // Logic from VOPRF::Verify: e(H(m), pk) == e(output, g2)
+        *result = voprf::Pairing::Check(voprf::Point::HashToPoint(input_msg, input_msg_len), pk->pk, output_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
 
-        // Logic from VOPRF::Verify
-        voprf::Pairing e1 = voprf::Pairing::Pair(voprf::Point::HashToPoint(msg_str), pk->pk);
-        voprf::Pairing e2 = voprf::Pairing::Pair(output_point->p, voprf::VerificationKey::GetBase());
-        
-        *result = (e1 == e2);
+extern "C" int voprf_verify_batch(const voprf_public_key_t* pk, const uint8_t* const* input_msgs, const size_t* input_msg_lens, const voprf_point_t* const* output_points, size_t n, bool* results, bool* all_valid, size_t num_threads) {
+    CHECK_NULL_ARG(pk);
+    VOPRF_TRY
+        // Bisection may run several checks, so prepare the key once.
+        voprf::PreparedVerificationKey prepared(pk->pk);
+        return verify_batch(prepared, input_msgs, input_msg_lens, output_points, n, results, all_valid, num_threads);
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Prepared Server Context
+//----------------------------------------------------------------
+
+extern "C" int voprf_server_ctx_create(const voprf_private_key_t* sk, voprf_server_ctx_t** ctx) {
+    CHECK_NULL_ARG(sk);
+    CHECK_NULL_ARG(ctx);
+    VOPRF_TRY
+        voprf_server_ctx_t* new_ctx = new voprf_server_ctx_t{voprf::PreparedKey(sk->sk), voprf::Proof::ProofKey(sk->sk)};
+        *ctx = new_ctx;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_server_ctx_destroy(voprf_server_ctx_t* ctx) {
+    delete ctx;
+}
+
+extern "C" int voprf_server_ctx_evaluate(const voprf_server_ctx_t* ctx, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(ctx);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    VOPRF_TRY
+        voprf_point_t* new_point = new voprf_point_t{ctx->key.Mul(blinded_point->p)};
+        *evaluated_point = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_server_ctx_evaluate_batch(const voprf_server_ctx_t* ctx, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE_BATCH);
+    CHECK_NULL_ARG(ctx);
+    return evaluate_batch(ctx->key, in, n, out, num_threads);
+}
+
+//----------------------------------------------------------------
+// Prepared Verifier
+//----------------------------------------------------------------
+
+extern "C" int voprf_verifier_create(const voprf_public_key_t* pk, voprf_verifier_t** verifier) {
+    CHECK_NULL_ARG(pk);
+    CHECK_NULL_ARG(verifier);
+    VOPRF_TRY
+        voprf_verifier_t* new_verifier = new voprf_verifier_t{voprf::PreparedVerificationKey(pk->pk)};
+        *verifier = new_verifier;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_verifier_destroy(voprf_verifier_t* verifier) {
+    delete verifier;
+}
+
+extern "C" int voprf_verifier_verify(const voprf_verifier_t* verifier, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY);
+    CHECK_NULL_ARG(verifier);
+    CHECK_NULL_ARG(input_msg);
+    CHECK_NULL_ARG(output_point);
+    CHECK_NULL_ARG(result);
+    VOPRF_TRY
+        *result = voprf::Pairing::Check(voprf::Point::HashToPoint(input_msg, input_msg_len), verifier->pk, output_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_verifier_verify_batch(const voprf_verifier_t* verifier, const uint8_t* const* input_msgs, const size_t* input_msg_lens, const voprf_point_t* const* output_points, size_t n, bool* results, bool* all_valid, size_t num_threads) {
+    CHECK_NULL_ARG(verifier);
+    return verify_batch(verifier->pk, input_msgs, input_msg_lens, output_points, n, results, all_valid, num_threads);
+}
+
+//----------------------------------------------------------------
+// Caller-Provided Storage
+//----------------------------------------------------------------
+
+extern "C" size_t voprf_private_key_sizeof(void) {
+    return sizeof(voprf_private_key_t);
+}
+
+extern "C" size_t voprf_private_key_alignof(void) {
+    return alignof(voprf_private_key_t);
+}
+
+extern "C" int voprf_private_key_init(void* storage, size_t storage_len, voprf_private_key_t** key) {
+    CHECK_STORAGE(storage, storage_len, 1, voprf_private_key_t);
+    CHECK_NULL_ARG(key);
+    VOPRF_TRY
+        *key = new (storage) voprf_private_key_t();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_private_key_deinit(voprf_private_key_t* key) {
+    if (key) {
+        key->~voprf_private_key_t();
+    }
+}
+
+extern "C" size_t voprf_public_key_sizeof(void) {
+    return sizeof(voprf_public_key_t);
+}
+
+extern "C" size_t voprf_public_key_alignof(void) {
+    return alignof(voprf_public_key_t);
+}
+
+extern "C" int voprf_public_key_init(void* storage, size_t storage_len, voprf_public_key_t** key) {
+    CHECK_STORAGE(storage, storage_len, 1, voprf_public_key_t);
+    CHECK_NULL_ARG(key);
+    VOPRF_TRY
+        *key = new (storage) voprf_public_key_t();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_public_key_deinit(voprf_public_key_t* key) {
+    if (key) {
+        key->~voprf_public_key_t();
+    }
+}
+
+extern "C" size_t voprf_point_sizeof(void) {
+    return sizeof(voprf_point_t);
+}
+
+extern "C" size_t voprf_point_alignof(void) {
+    return alignof(voprf_point_t);
+}
+
+extern "C" int voprf_point_init(void* storage, size_t storage_len, voprf_point_t** point) {
+    CHECK_STORAGE(storage, storage_len, 1, voprf_point_t);
+    CHECK_NULL_ARG(point);
+    VOPRF_TRY
+        *point = new (storage) voprf_point_t();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_point_deinit(voprf_point_t* point) {
+    if (point) {
+        point->~voprf_point_t();
+    }
+}
+
+extern "C" int voprf_private_key_array_init(void* storage, size_t storage_len, size_t n, voprf_private_key_t** array) {
+    CHECK_STORAGE(storage, storage_len, n, voprf_private_key_t);
+    CHECK_NULL_ARG(array);
+    VOPRF_TRY
+        voprf_private_key_t* keys = static_cast<voprf_private_key_t*>(storage);
+        for (size_t i = 0; i < n; i++) {
+            new (&keys[i]) voprf_private_key_t();
+        }
+        *array = keys;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_private_key_array_deinit(voprf_private_key_t* array, size_t n) {
+    for (size_t i = 0; array && i < n; i++) {
+        array[i].~voprf_private_key_t();
+    }
+}
+
+extern "C" voprf_private_key_t* voprf_private_key_array_at(voprf_private_key_t* array, size_t index) {
+    return array ? &array[index] : nullptr;
+}
+
+extern "C" int voprf_point_array_init(void* storage, size_t storage_len, size_t n, voprf_point_t** array) {
+    CHECK_STORAGE(storage, storage_len, n, voprf_point_t);
+    CHECK_NULL_ARG(array);
+    VOPRF_TRY
+        voprf_point_t* points = static_cast<voprf_point_t*>(storage);
+        for (size_t i = 0; i < n; i++) {
+            new (&points[i]) voprf_point_t();
+        }
+        *array = points;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_point_array_deinit(voprf_point_t* array, size_t n) {
+    for (size_t i = 0; array && i < n; i++) {
+        array[i].~voprf_point_t();
+    }
+}
+
+extern "C" voprf_point_t* voprf_point_array_at(voprf_point_t* array, size_t index) {
+    return array ? &array[index] : nullptr;
+}
+
+extern "C" int voprf_private_key_generate_into(voprf_private_key_t* key) {
+    CHECK_NULL_ARG(key);
+    VOPRF_TRY
+        key->sk = voprf::SecretKey::Keygen();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_private_key_get_public_key_into(const voprf_private_key_t* private_key, voprf_public_key_t* public_key) {
+    CHECK_NULL_ARG(private_key);
+    CHECK_NULL_ARG(public_key);
+    VOPRF_TRY
+        public_key->pk = private_key->sk.GetVerificationKey();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_private_key_from_bytes_into(voprf_private_key_t* key, const uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
+    CHECK_NULL_ARG(key);
+    CHECK_NULL_ARG(buffer);
+    VOPRF_TRY
+        size_t read = key->sk.Deserialize(buffer, buffer_len);
+        if (read == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, read);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_public_key_from_bytes_into(voprf_public_key_t* key, const uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
+    CHECK_NULL_ARG(key);
+    CHECK_NULL_ARG(buffer);
+    VOPRF_TRY
+        size_t read = key->pk.Deserialize(buffer, buffer_len);
+        if (read == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, read);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_point_from_bytes_into(voprf_point_t* point, const uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
+    CHECK_NULL_ARG(point);
+    CHECK_NULL_ARG(buffer);
+    VOPRF_TRY
+        size_t read = point->p.Deserialize(buffer, buffer_len);
+        if (read == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, read);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_blind_into(const uint8_t* msg, size_t msg_len, voprf_private_key_t* blinding_factor, voprf_point_t* blinded_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_BLIND);
+    CHECK_NULL_ARG(msg);
+    CHECK_NULL_ARG(blinding_factor);
+    CHECK_NULL_ARG(blinded_point);
+    VOPRF_TRY
+        voprf::SecretKey r = voprf::SecretKey::Keygen();
+        blinded_point->p = voprf::Point::Mul(voprf::Point::HashToPoint(msg, msg_len), r);
+        blinding_factor->sk = r;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_evaluate_into(const voprf_private_key_t* sk, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(sk);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    VOPRF_TRY
+        evaluated_point->p = voprf::Point::Mul(blinded_point->p, sk->sk);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_unblind_into(const voprf_point_t* evaluated_point, const voprf_private_key_t* blinding_factor, voprf_point_t* final_output) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_UNBLIND);
+    CHECK_NULL_ARG(evaluated_point);
+    CHECK_NULL_ARG(blinding_factor);
+    CHECK_NULL_ARG(final_output);
+    VOPRF_TRY
+        voprf::SecretKey r_inv = blinding_factor->sk.Inverse();
+        final_output->p = voprf::Point::Mul(evaluated_point->p, r_inv);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_server_ctx_evaluate_into(const voprf_server_ctx_t* ctx, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(ctx);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    VOPRF_TRY
+        evaluated_point->p = ctx->key.Mul(blinded_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_server_ctx_evaluate_batch_into(const voprf_server_ctx_t* ctx, const voprf_point_t* const* in, size_t n, voprf_point_t* const* out, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE_BATCH);
+    CHECK_NULL_ARG(ctx);
+    if (n == 0) {
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(in);
+    CHECK_NULL_ARG(out);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(in[i]);
+        CHECK_NULL_ARG(out[i]);
+    }
+    VOPRF_TRY
+        evaluate_batch_into(ctx->key, in, n, out, num_threads);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Wire Formats
+//----------------------------------------------------------------
+
+// Maps a C format tag to the internal format. Returns false for an unknown tag.
+static bool to_format(int tag, voprf::Format* format) {
+    switch (tag) {
+        case VOPRF_FORMAT_COMPRESSED:
+            *format = voprf::COMPRESSED;
+            return true;
+        case VOPRF_FORMAT_UNCOMPRESSED:
+            *format = voprf::UNCOMPRESSED;
+            return true;
+    }
+    return false;
+}
+
+// Maps a C validation mode to the internal one. Returns false for an unknown mode.
+static bool to_validation(voprf_validation mode, voprf::Validation* validation) {
+    switch (mode) {
+        case VOPRF_VALIDATE_STRICT:
+            *validation = voprf::STRICT;
+            return true;
+        case VOPRF_VALIDATE_TRUSTED:
+            *validation = voprf::TRUSTED;
+            return true;
+    }
+    return false;
+}
+
+extern "C" int voprf_point_to_tagged_bytes(const voprf_point_t* point, voprf_format format, uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_SERIALIZE);
+    CHECK_NULL_ARG(point);
+    CHECK_NULL_ARG(buffer);
+    voprf::Format f;
+    if (!to_format(format, &f)) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    const size_t size = voprf::Point::ByteSize(f);
+    if (buffer_len < 1 + size) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        buffer[0] = static_cast<uint8_t>(format);
+        if (point->p.Serialize(buffer + 1, size, f) != size) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(SERIALIZED, 1 + size);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_point_from_tagged_bytes_into(voprf_point_t* point, const uint8_t* buffer, size_t buffer_len, voprf_validation mode) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
+    CHECK_NULL_ARG(point);
+    CHECK_NULL_ARG(buffer);
+    voprf::Validation validation;
+    if (!to_validation(mode, &validation)) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    voprf::Format f;
+    if (buffer_len < 1 || !to_format(buffer[0], &f)) {
+        return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+    }
+    const size_t size = voprf::Point::ByteSize(f);
+    if (buffer_len < 1 + size) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        if (point->p.Deserialize(buffer + 1, size, validation, f) != size) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, 1 + size);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_public_key_to_tagged_bytes(const voprf_public_key_t* key, voprf_format format, uint8_t* buffer, size_t buffer_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_SERIALIZE);
+    CHECK_NULL_ARG(key);
+    CHECK_NULL_ARG(buffer);
+    voprf::Format f;
+    if (!to_format(format, &f)) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    const size_t size = voprf::VerificationKey::ByteSize(f);
+    if (buffer_len < 1 + size) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        buffer[0] = static_cast<uint8_t>(format);
+        if (key->pk.Serialize(buffer + 1, size, f) != size) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(SERIALIZED, 1 + size);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_public_key_from_tagged_bytes_into(voprf_public_key_t* key, const uint8_t* buffer, size_t buffer_len, voprf_validation mode) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
+    CHECK_NULL_ARG(key);
+    CHECK_NULL_ARG(buffer);
+    voprf::Validation validation;
+    if (!to_validation(mode, &validation)) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    voprf::Format f;
+    if (buffer_len < 1 || !to_format(buffer[0], &f)) {
+        return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+    }
+    const size_t size = voprf::VerificationKey::ByteSize(f);
+    if (buffer_len < 1 + size) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        if (key->pk.Deserialize(buffer + 1, size, validation, f) != size) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, 1 + size);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Batch Serialization
+//----------------------------------------------------------------
+
+extern "C" int voprf_points_from_bytes(const uint8_t* buffer, size_t buffer_len, size_t n, voprf_format format, voprf_point_t* points, voprf_validation mode, size_t num_threads, size_t* failed_index) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_DESERIALIZE);
+    if (n == 0) {
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(buffer);
+    CHECK_NULL_ARG(points);
+    voprf::Format f;
+    voprf::Validation validation;
+    if (!to_format(format, &f) || !to_validation(mode, &validation)) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    const size_t size = voprf::Point::ByteSize(f);
+    if (n > SIZE_MAX / size || buffer_len < n * size) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        std::atomic<size_t> first_bad(SIZE_MAX);
+        voprf::Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                if (points[i].p.Deserialize(buffer + i * size, size, validation, f) != size) {
+                    size_t seen = first_bad.load();
+                    while (i < seen && !first_bad.compare_exchange_weak(seen, i)) {
+                    }
+                    return;
+                }
+            }
+        });
+        if (first_bad.load() != SIZE_MAX) {
+            if (failed_index) {
+                *failed_index = first_bad.load();
+            }
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(DESERIALIZED, n * size);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_points_to_bytes(const voprf_point_t* const* points, size_t n, voprf_format format, uint8_t* buffer, size_t buffer_len, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_SERIALIZE);
+    if (n == 0) {
+        return VOPRF_SUCCESS;
+    }
+    CHECK_NULL_ARG(points);
+    CHECK_NULL_ARG(buffer);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(points[i]);
+    }
+    voprf::Format f;
+    if (!to_format(format, &f)) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    const size_t size = voprf::Point::ByteSize(f);
+    if (n > SIZE_MAX / size || buffer_len < n * size) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        std::atomic<bool> ok(true);
+        voprf::Parallel::For(n, num_threads, [&](size_t begin, size_t end) {
+            auto get = [&](size_t i) -> const voprf::Point& {
+                return points[begin + i]->p;
+            };
+            if (!voprf::Point::SerializeBatch(get, end - begin, buffer + begin * size, f)) {
+                ok = false;
+            }
+        });
+        if (!ok) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
+        }
+        VOPRF_STATS_BYTES(SERIALIZED, n * size);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Blinding Factor Pool
+//----------------------------------------------------------------
+
+extern "C" int voprf_blind_pool_create(size_t capacity, bool background, voprf_blind_pool_t** pool) {
+    CHECK_NULL_ARG(pool);
+    VOPRF_TRY
+        *pool = new voprf_blind_pool_t(capacity, background);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_blind_pool_destroy(voprf_blind_pool_t* pool) {
+    delete pool;
+}
+
+extern "C" int voprf_blind_pool_fill(voprf_blind_pool_t* pool) {
+    CHECK_NULL_ARG(pool);
+    VOPRF_TRY
+        pool->pool.Fill();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_blind_pool_size(const voprf_blind_pool_t* pool, size_t* size) {
+    CHECK_NULL_ARG(pool);
+    CHECK_NULL_ARG(size);
+    VOPRF_TRY
+        *size = pool->pool.Size();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_blind_pooled_into(voprf_blind_pool_t* pool, const uint8_t* msg, size_t msg_len, voprf_private_key_t* unblinding_factor, voprf_point_t* blinded_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_BLIND);
+    CHECK_NULL_ARG(pool);
+    CHECK_NULL_ARG(msg);
+    CHECK_NULL_ARG(unblinding_factor);
+    CHECK_NULL_ARG(blinded_point);
+    VOPRF_TRY
+        voprf::BlindingPair pair = pool->pool.Take();
+        blinded_point->p = voprf::Point::Mul(voprf::Point::HashToPoint(msg, msg_len), pair.r);
+        unblinding_factor->sk = pair.r_inv;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_blind_pooled(voprf_blind_pool_t* pool, const uint8_t* msg, size_t msg_len, voprf_private_key_t** unblinding_factor, voprf_point_t** blinded_point) {
+    CHECK_NULL_ARG(unblinding_factor);
+    CHECK_NULL_ARG(blinded_point);
+    VOPRF_TRY
+        std::unique_ptr<voprf_private_key_t> r_inv_out(new voprf_private_key_t());
+        std::unique_ptr<voprf_point_t> x_out(new voprf_point_t());
+        int status = voprf_blind_pooled_into(pool, msg, msg_len, r_inv_out.get(), x_out.get());
+        if (status != VOPRF_SUCCESS) {
+            return status;
+        }
+        *unblinding_factor = r_inv_out.release();
+        *blinded_point = x_out.release();
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_unblind_pooled_into(const voprf_point_t* evaluated_point, const voprf_private_key_t* unblinding_factor, voprf_point_t* final_output) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_UNBLIND);
+    CHECK_NULL_ARG(evaluated_point);
+    CHECK_NULL_ARG(unblinding_factor);
+    CHECK_NULL_ARG(final_output);
+    VOPRF_TRY
+        // The factor is already inverted, so this is a single multiplication.
+        final_output->p = voprf::Point::Mul(evaluated_point->p, unblinding_factor->sk);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_unblind_pooled(const voprf_point_t* evaluated_point, const voprf_private_key_t* unblinding_factor, voprf_point_t** final_output) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_UNBLIND);
+    CHECK_NULL_ARG(evaluated_point);
+    CHECK_NULL_ARG(unblinding_factor);
+    CHECK_NULL_ARG(final_output);
+    VOPRF_TRY
+        voprf::Point result = voprf::Point::Mul(evaluated_point->p, unblinding_factor->sk);
+
+        voprf_point_t* new_point = new voprf_point_t{result};
+        *final_output = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Hash-to-Point Cache
+//----------------------------------------------------------------
+
+extern "C" int voprf_hash_cache_create(size_t capacity, voprf_hash_cache_t** cache) {
+    CHECK_NULL_ARG(cache);
+    VOPRF_TRY
+        *cache = new voprf_hash_cache_t(capacity);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_hash_cache_destroy(voprf_hash_cache_t* cache) {
+    delete cache;
+}
+
+extern "C" int voprf_hash_cache_get_stats(voprf_hash_cache_t* cache, uint64_t* hits, uint64_t* misses, size_t* size) {
+    CHECK_NULL_ARG(cache);
+    VOPRF_TRY
+        voprf::HashCache::Stats stats = cache->cache.GetStats();
+        if (hits) {
+            *hits = stats.hits;
+        }
+        if (misses) {
+            *misses = stats.misses;
+        }
+        if (size) {
+            *size = stats.size;
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_verify_cached(const voprf_public_key_t* pk, voprf_hash_cache_t* cache, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY);
+    CHECK_NULL_ARG(pk);
+    CHECK_NULL_ARG(cache);
+    CHECK_NULL_ARG(input_msg);
+    CHECK_NULL_ARG(output_point);
+    CHECK_NULL_ARG(result);
+    VOPRF_TRY
+        voprf::Point hashed = cache->cache.HashToPoint(input_msg, input_msg_len);
+        *result = voprf::Pairing::Check(hashed, pk->pk, output_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_verifier_verify_cached(const voprf_verifier_t* verifier, voprf_hash_cache_t* cache, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY);
+    CHECK_NULL_ARG(verifier);
+    CHECK_NULL_ARG(cache);
+    CHECK_NULL_ARG(input_msg);
+    CHECK_NULL_ARG(output_point);
+    CHECK_NULL_ARG(result);
+    VOPRF_TRY
+        voprf::Point hashed = cache->cache.HashToPoint(input_msg, input_msg_len);
+        *result = voprf::Pairing::Check(hashed, verifier->pk, output_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Verifiable Evaluation
+//----------------------------------------------------------------
+
+extern "C" int voprf_private_key_get_proof_key(const voprf_private_key_t* private_key, voprf_point_t** proof_key) {
+    CHECK_NULL_ARG(private_key);
+    CHECK_NULL_ARG(proof_key);
+    VOPRF_TRY
+        voprf_point_t* new_point = new voprf_point_t{voprf::Proof::ProofKey(private_key->sk)};
+        *proof_key = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_server_ctx_get_proof_key(const voprf_server_ctx_t* ctx, voprf_point_t** proof_key) {
+    CHECK_NULL_ARG(ctx);
+    CHECK_NULL_ARG(proof_key);
+    VOPRF_TRY
+        voprf_point_t* new_point = new voprf_point_t{ctx->proof_key};
+        *proof_key = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_evaluate_with_proof(const voprf_private_key_t* sk, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point, uint8_t* proof, size_t proof_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(sk);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    CHECK_NULL_ARG(proof);
+    if (proof_len < voprf::Proof::BYTE_SIZE) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        voprf::Point z = voprf::Point::Mul(blinded_point->p, sk->sk);
+        voprf::Proof p = voprf::Proof::Prove(sk->sk, voprf::Proof::ProofKey(sk->sk), blinded_point->p, z);
+        if (p.Serialize(proof, proof_len) == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
+        }
+        voprf_point_t* new_point = new voprf_point_t{z};
+        *evaluated_point = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_server_ctx_evaluate_with_proof(const voprf_server_ctx_t* ctx, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point, uint8_t* proof, size_t proof_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(ctx);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    CHECK_NULL_ARG(proof);
+    if (proof_len < voprf::Proof::BYTE_SIZE) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    VOPRF_TRY
+        voprf::Point z = ctx->key.Mul(blinded_point->p);
+        voprf::Proof p = voprf::Proof::Prove(ctx->key.GetSecretKey(), ctx->proof_key, blinded_point->p, z);
+        if (p.Serialize(proof, proof_len) == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_SERIALIZATION);
+        }
+        voprf_point_t* new_point = new voprf_point_t{z};
+        *evaluated_point = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_verify_proof(const voprf_point_t* proof_key, const voprf_point_t* blinded_point, const voprf_point_t* evaluated_point, const uint8_t* proof, size_t proof_len, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY);
+    CHECK_NULL_ARG(proof_key);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    CHECK_NULL_ARG(proof);
+    CHECK_NULL_ARG(result);
+    VOPRF_TRY
+        voprf::Proof p;
+        if (p.Deserialize(proof, proof_len) == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        *result = p.Verify(proof_key->p, blinded_point->p, evaluated_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_server_ctx_evaluate_batch_with_proof(const voprf_server_ctx_t* ctx, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads, uint8_t* proof, size_t proof_len) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE_BATCH);
+    CHECK_NULL_ARG(ctx);
+    CHECK_NULL_ARG(proof);
+    if (n == 0) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    if (proof_len < voprf::Proof::BYTE_SIZE) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_BUFFER_SIZE);
+    }
+    int status = evaluate_batch(ctx->key, in, n, out, num_threads);
+    if (status != VOPRF_SUCCESS) {
+        return status;
+    }
+    VOPRF_TRY
+        try {
+            std::vector<voprf::Point> ms(n);
+            std::vector<voprf::Point> zs(n);
+            for (size_t i = 0; i < n; i++) {
+                ms[i] = in[i]->p;
+                zs[i] = out[i]->p;
+            }
+            voprf::Proof p = voprf::Proof::ProveBatch(ctx->key.GetSecretKey(), ctx->proof_key, ms, zs);
+            if (p.Serialize(proof, proof_len) == 0) {
+                throw std::runtime_error("voprf: proof serialization failed");
+            }
+        } catch (...) {
+            for (size_t i = 0; i < n; i++) {
+                delete out[i];
+                out[i] = nullptr;
+            }
+            throw;
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_verify_proof_batch(const voprf_point_t* proof_key, const voprf_point_t* const* blinded_points, const voprf_point_t* const* evaluated_points, size_t n, const uint8_t* proof, size_t proof_len, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY_BATCH);
+    CHECK_NULL_ARG(proof_key);
+    CHECK_NULL_ARG(blinded_points);
+    CHECK_NULL_ARG(evaluated_points);
+    CHECK_NULL_ARG(proof);
+    CHECK_NULL_ARG(result);
+    if (n == 0) {
+        return VOPRF_FAIL(VOPRF_ERROR_INVALID_ARGUMENT);
+    }
+    for (size_t i = 0; i < n; i++) {
+        CHECK_NULL_ARG(blinded_points[i]);
+        CHECK_NULL_ARG(evaluated_points[i]);
+    }
+    VOPRF_TRY
+        voprf::Proof p;
+        if (p.Deserialize(proof, proof_len) == 0) {
+            return VOPRF_FAIL(VOPRF_ERROR_DESERIALIZATION);
+        }
+        std::vector<voprf::Point> ms(n);
+        std::vector<voprf::Point> zs(n);
+        for (size_t i = 0; i < n; i++) {
+            ms[i] = blinded_points[i]->p;
+            zs[i] = evaluated_points[i]->p;
+        }
+        *result = p.VerifyBatch(proof_key->p, ms, zs);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Keyring
+//----------------------------------------------------------------
+
+extern "C" int voprf_public_key_get_id(const voprf_public_key_t* pk, uint64_t* key_id) {
+    CHECK_NULL_ARG(pk);
+    CHECK_NULL_ARG(key_id);
+    VOPRF_TRY
+        *key_id = voprf::Keyring::KeyId(pk->pk);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_keyring_create(voprf_keyring_t** keyring) {
+    CHECK_NULL_ARG(keyring);
+    VOPRF_TRY
+        voprf_keyring_t* new_keyring = new voprf_keyring_t();
+        *keyring = new_keyring;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" void voprf_keyring_destroy(voprf_keyring_t* keyring) {
+    delete keyring;
+}
+
+extern "C" int voprf_keyring_add(voprf_keyring_t* keyring, const voprf_private_key_t* sk, uint64_t* key_id) {
+    CHECK_NULL_ARG(keyring);
+    CHECK_NULL_ARG(sk);
+    VOPRF_TRY
+        uint64_t id = keyring->keyring.Add(sk->sk);
+        if (key_id) {
+            *key_id = id;
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_keyring_retire(voprf_keyring_t* keyring, uint64_t key_id) {
+    CHECK_NULL_ARG(keyring);
+    VOPRF_TRY
+        if (!keyring->keyring.Retire(key_id)) {
+            return VOPRF_FAIL(VOPRF_ERROR_UNKNOWN_KEY);
+        }
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_keyring_size(const voprf_keyring_t* keyring, size_t* size) {
+    CHECK_NULL_ARG(keyring);
+    CHECK_NULL_ARG(size);
+    *size = keyring->keyring.Size();
+    return VOPRF_SUCCESS;
+}
+
+extern "C" int voprf_keyring_get_public_key(const voprf_keyring_t* keyring, uint64_t key_id, voprf_public_key_t** public_key) {
+    CHECK_NULL_ARG(keyring);
+    CHECK_NULL_ARG(public_key);
+    VOPRF_TRY
+        voprf::Keyring::Lookup entry(keyring->keyring, key_id);
+        if (!entry) {
+            return VOPRF_FAIL(VOPRF_ERROR_UNKNOWN_KEY);
+        }
+        voprf_public_key_t* new_key = new voprf_public_key_t{entry->pk.GetVerificationKey()};
+        *public_key = new_key;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_keyring_evaluate(const voprf_keyring_t* keyring, uint64_t key_id, const voprf_point_t* blinded_point, voprf_point_t** evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(keyring);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    VOPRF_TRY
+        voprf::Keyring::Lookup entry(keyring->keyring, key_id);
+        if (!entry) {
+            return VOPRF_FAIL(VOPRF_ERROR_UNKNOWN_KEY);
+        }
+        voprf_point_t* new_point = new voprf_point_t{entry->key.Mul(blinded_point->p)};
+        *evaluated_point = new_point;
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_keyring_evaluate_into(const voprf_keyring_t* keyring, uint64_t key_id, const voprf_point_t* blinded_point, voprf_point_t* evaluated_point) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE);
+    CHECK_NULL_ARG(keyring);
+    CHECK_NULL_ARG(blinded_point);
+    CHECK_NULL_ARG(evaluated_point);
+    VOPRF_TRY
+        voprf::Keyring::Lookup entry(keyring->keyring, key_id);
+        if (!entry) {
+            return VOPRF_FAIL(VOPRF_ERROR_UNKNOWN_KEY);
+        }
+        evaluated_point->p = entry->key.Mul(blinded_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+extern "C" int voprf_keyring_evaluate_batch(const voprf_keyring_t* keyring, uint64_t key_id, const voprf_point_t* const* in, size_t n, voprf_point_t** out, size_t num_threads) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_EVALUATE_BATCH);
+    CHECK_NULL_ARG(keyring);
+    voprf::Keyring::Lookup entry(keyring->keyring, key_id);
+    if (!entry) {
+        return VOPRF_FAIL(VOPRF_ERROR_UNKNOWN_KEY);
+    }
+    return evaluate_batch(entry->key, in, n, out, num_threads);
+}
+
+extern "C" int voprf_keyring_verify(const voprf_keyring_t* keyring, uint64_t key_id, const uint8_t* input_msg, size_t input_msg_len, const voprf_point_t* output_point, bool* result) {
+    VOPRF_STATS_TIMER(VOPRF_STATS_OP_VERIFY);
+    CHECK_NULL_ARG(keyring);
+    CHECK_NULL_ARG(input_msg);
+    CHECK_NULL_ARG(output_point);
+    CHECK_NULL_ARG(result);
+    VOPRF_TRY
+        voprf::Keyring::Lookup entry(keyring->keyring, key_id);
+        if (!entry) {
+            return VOPRF_FAIL(VOPRF_ERROR_UNKNOWN_KEY);
+        }
+        *result = voprf::Pairing::Check(voprf::Point::HashToPoint(input_msg, input_msg_len), entry->pk, output_point->p);
+        return VOPRF_SUCCESS;
+    VOPRF_CATCH
+}
+
+//----------------------------------------------------------------
+// Statistics
+//----------------------------------------------------------------
+
+extern "C" int voprf_stats_snapshot(voprf_stats_t* stats) {
+    CHECK_NULL_ARG(stats);
+    VOPRF_TRY
+        memset(stats, 0, sizeof(*stats));
+#ifdef VOPRF_ENABLE_STATS
+        voprf::stats::Snapshot(stats);
+#endif
         return VOPRF_SUCCESS;
     VOPRF_CATCH
 }
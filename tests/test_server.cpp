@@ -0,0 +1,410 @@
+// End-to-end tests for tools/voprf_server and tools/voprf_loadgen.
+//
+// Starts the server on a socket in the temporary directory with a freshly
+// generated key, talks to it directly to check its responses, its handling
+// of bad input and its per-connection backpressure, then runs the load
+// generator against it and finally stops it with SIGTERM.
+//
+// Usage: run_server_tests SERVER_BINARY LOADGEN_BINARY
+
+#include "voprf/voprf.h"
+
+#include "server_protocol.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                             \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_OK(expr) CHECK((expr) == 0)
+
+    // Distinct blinded points cycled through by every test, with the
+    // server's expected answer for each.
+    const size_t POOL_SIZE = 16;
+
+    // Well past the server's 4 MiB output high-water mark.
+    const size_t FLOOD_REQUESTS = 8 * 1024 * 1024 / protocol::RESPONSE_FRAME_BYTES;
+
+    struct Pool {
+        uint8_t blinded[POOL_SIZE][VOPRF_POINT_BYTES];
+        uint8_t evaluated[POOL_SIZE][VOPRF_POINT_BYTES];
+    };
+
+    // A path in the temporary directory, removed when the test ends.
+    struct TempPath {
+        std::string path;
+
+        explicit TempPath(const char* name) {
+            const char* dir = std::getenv("TMPDIR");
+            path = std::string(dir && *dir ? dir : "/tmp") + "/voprf_server_test_" + std::to_string(getpid()) + "_" + name;
+        }
+
+        ~TempPath() {
+            unlink(path.c_str());
+        }
+    };
+
+    // Runs args[0] with args, sending its stderr to stderr_path if given.
+    pid_t Spawn(const std::vector<std::string>& args, const char* stderr_path = nullptr) {
+        std::vector<char*> argv;
+        for (const auto& a : args) {
+            argv.push_back(const_cast<char*>(a.c_str()));
+        }
+        argv.push_back(nullptr);
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (stderr_path) {
+                int fd = open(stderr_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+                if (fd < 0 || dup2(fd, STDERR_FILENO) < 0) {
+                    _exit(127);
+                }
+                close(fd);
+            }
+            execv(argv[0], argv.data());
+            std::fprintf(stderr, "exec %s: %s\n", argv[0], std::strerror(errno));
+            _exit(127);
+        }
+        return pid;
+    }
+
+    // Waits for pid and returns its exit status, or -1 if it did not exit
+    // normally.
+    int Wait(pid_t pid) {
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) {
+                return -1;
+            }
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    int Connect(const std::string& path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), path.size());
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+        return fd;
+    }
+
+    // Connects once the server is listening, giving it a few seconds to
+    // start.
+    int ConnectWhenUp(const std::string& path) {
+        for (int attempt = 0; attempt < 100; attempt++) {
+            int fd = Connect(path);
+            if (fd >= 0) {
+                return fd;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return -1;
+    }
+
+    bool SendAll(int fd, const uint8_t* p, size_t n) {
+        while (n > 0) {
+            ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                return false;
+            }
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+        return true;
+    }
+
+    bool RecvAll(int fd, uint8_t* p, size_t n) {
+        while (n > 0) {
+            ssize_t r = read(fd, p, n);
+            if (r < 0 && errno == EINTR) {
+                continue;
+            }
+            if (r <= 0) {
+                return false;
+            }
+            p += r;
+            n -= static_cast<size_t>(r);
+        }
+        return true;
+    }
+
+    void Frame(uint8_t* frame, uint32_t id, const uint8_t* point) {
+        protocol::PutU32(frame, protocol::REQUEST_BODY_BYTES);
+        protocol::PutU32(frame + 4, id);
+        memcpy(frame + 8, point, VOPRF_POINT_BYTES);
+    }
+
+    void MakePool(const voprf_private_key_t* sk, Pool& pool) {
+        for (size_t i = 0; i < POOL_SIZE; i++) {
+            std::string msg = "server test " + std::to_string(i);
+            voprf_private_key_t* r = nullptr;
+            voprf_point_t* blinded = nullptr;
+            voprf_point_t* evaluated = nullptr;
+            CHECK_OK(voprf_blind(reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), &r, &blinded));
+            CHECK_OK(voprf_evaluate(sk, blinded, &evaluated));
+            CHECK_OK(voprf_point_to_bytes(blinded, pool.blinded[i], VOPRF_POINT_BYTES));
+            CHECK_OK(voprf_point_to_bytes(evaluated, pool.evaluated[i], VOPRF_POINT_BYTES));
+            voprf_point_destroy(evaluated);
+            voprf_point_destroy(blinded);
+            voprf_private_key_destroy(r);
+        }
+    }
+
+    // Pipelined requests are all answered with the right evaluation, and an
+    // undecodable point gets an error status without affecting the rest.
+    void TestResponses(const std::string& socket_path, const Pool& pool) {
+        int fd = ConnectWhenUp(socket_path);
+        CHECK(fd >= 0);
+        if (fd < 0) {
+            return;
+        }
+        const uint32_t n = 200;
+        const uint32_t bad_id = n;
+        std::vector<uint8_t> frames((n + 1) * protocol::REQUEST_FRAME_BYTES);
+        for (uint32_t i = 0; i < n; i++) {
+            Frame(&frames[i * protocol::REQUEST_FRAME_BYTES], i, pool.blinded[i % POOL_SIZE]);
+        }
+        uint8_t garbage[VOPRF_POINT_BYTES];
+        memset(garbage, 0xff, sizeof(garbage));
+        Frame(&frames[n * protocol::REQUEST_FRAME_BYTES], bad_id, garbage);
+        CHECK(SendAll(fd, frames.data(), frames.size()));
+
+        // Responses may come back in any order.
+        std::vector<bool> seen(n + 1, false);
+        uint8_t zero[VOPRF_POINT_BYTES];
+        memset(zero, 0, sizeof(zero));
+        for (uint32_t k = 0; k <= n; k++) {
+            uint8_t response[protocol::RESPONSE_FRAME_BYTES];
+            bool received = RecvAll(fd, response, sizeof(response));
+            CHECK(received);
+            if (!received) {
+                break;
+            }
+            CHECK(protocol::GetU32(response) == protocol::RESPONSE_BODY_BYTES);
+            uint32_t id = protocol::GetU32(response + 4);
+            CHECK(id <= n && !seen[id]);
+            if (id > n) {
+                continue;
+            }
+            seen[id] = true;
+            if (id == bad_id) {
+                CHECK(response[8] == protocol::BAD_POINT);
+                CHECK(memcmp(response + 9, zero, VOPRF_POINT_BYTES) == 0);
+            } else {
+                CHECK(response[8] == protocol::OK);
+                CHECK(memcmp(response + 9, pool.evaluated[id % POOL_SIZE], VOPRF_POINT_BYTES) == 0);
+            }
+        }
+        close(fd);
+    }
+
+    // A frame with the wrong length closes the connection.
+    void TestMalformedFrame(const std::string& socket_path) {
+        int fd = ConnectWhenUp(socket_path);
+        CHECK(fd >= 0);
+        if (fd < 0) {
+            return;
+        }
+        uint8_t frame[protocol::REQUEST_FRAME_BYTES];
+        memset(frame, 0, sizeof(frame));
+        protocol::PutU32(frame, protocol::REQUEST_BODY_BYTES + 1);
+        CHECK(SendAll(fd, frame, sizeof(frame)));
+        uint8_t byte;
+        CHECK(read(fd, &byte, 1) == 0);
+        close(fd);
+    }
+
+    // A client that floods requests without reading responses is stopped
+    // at the high-water mark rather than buffered without bound, and is
+    // served in full once it starts reading.
+    void TestBackpressure(const std::string& socket_path, const Pool& pool) {
+        int fd = ConnectWhenUp(socket_path);
+        CHECK(fd >= 0);
+        if (fd < 0) {
+            return;
+        }
+        std::vector<uint8_t> frames(FLOOD_REQUESTS * protocol::REQUEST_FRAME_BYTES);
+        for (size_t i = 0; i < FLOOD_REQUESTS; i++) {
+            Frame(&frames[i * protocol::REQUEST_FRAME_BYTES], static_cast<uint32_t>(i), pool.blinded[i % POOL_SIZE]);
+        }
+
+        // Send without reading until the server stops taking input.
+        size_t sent = 0;
+        while (sent < frames.size()) {
+            ssize_t w = send(fd, frames.data() + sent, frames.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (w > 0) {
+                sent += static_cast<size_t>(w);
+                continue;
+            }
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd p = {fd, POLLOUT, 0};
+                if (poll(&p, 1, 500) == 0) {
+                    break;
+                }
+                continue;
+            }
+            break;
+        }
+        CHECK(sent < frames.size());
+
+        // Then read every response while sending the rest.
+        size_t received = 0;
+        size_t wrong = 0;
+        std::thread reader([&] {
+            std::vector<bool> seen(FLOOD_REQUESTS, false);
+            uint8_t response[protocol::RESPONSE_FRAME_BYTES];
+            while (received < FLOOD_REQUESTS && RecvAll(fd, response, sizeof(response))) {
+                uint32_t id = protocol::GetU32(response + 4);
+                if (id >= FLOOD_REQUESTS || seen[id] || response[8] != protocol::OK ||
+                    memcmp(response + 9, pool.evaluated[id % POOL_SIZE], VOPRF_POINT_BYTES) != 0) {
+                    wrong++;
+                } else {
+                    seen[id] = true;
+                }
+                received++;
+            }
+        });
+        CHECK(SendAll(fd, frames.data() + sent, frames.size() - sent));
+        reader.join();
+        CHECK(received == FLOOD_REQUESTS);
+        CHECK(wrong == 0);
+        close(fd);
+    }
+
+    // At low load every request is its own batch: the idle workers that
+    // wake for a request and lose the race for it must not report empty
+    // batches of their own. Uses a separate server so that the counts
+    // printed on shutdown cover this test alone.
+    void TestIdleBatches(const std::string& server_binary, const std::string& key_path, const Pool& pool) {
+        TempPath socket_path("idle_sock");
+        TempPath log_path("idle_log");
+        pid_t server = Spawn({server_binary, "--key", key_path, "--socket", socket_path.path, "--workers", "4"}, log_path.path.c_str());
+        CHECK(server > 0);
+        if (server <= 0) {
+            return;
+        }
+        const uint32_t n = 50;
+        int fd = ConnectWhenUp(socket_path.path);
+        CHECK(fd >= 0);
+        for (uint32_t i = 0; fd >= 0 && i < n; i++) {
+            uint8_t frame[protocol::REQUEST_FRAME_BYTES];
+            uint8_t response[protocol::RESPONSE_FRAME_BYTES];
+            Frame(frame, i, pool.blinded[i % POOL_SIZE]);
+            bool answered = SendAll(fd, frame, sizeof(frame)) && RecvAll(fd, response, sizeof(response));
+            CHECK(answered);
+            if (!answered) {
+                break;
+            }
+            CHECK(protocol::GetU32(response + 4) == i && response[8] == protocol::OK);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        kill(server, SIGTERM);
+        CHECK(Wait(server) == 0);
+
+        // The last line reads "voprf_server: R requests in B batches ...".
+        unsigned long long requests = 0;
+        unsigned long long batches = 0;
+        bool found = false;
+        FILE* log = std::fopen(log_path.path.c_str(), "r");
+        char line[256];
+        while (log && std::fgets(line, sizeof(line), log)) {
+            found = found || std::sscanf(line, "voprf_server: %llu requests in %llu batches", &requests, &batches) == 2;
+        }
+        if (log) {
+            std::fclose(log);
+        }
+        CHECK(found);
+        CHECK(requests == n);
+        CHECK(batches == n);
+    }
+
+    void TestLoadgen(const std::string& loadgen, const std::string& socket_path) {
+        pid_t pid = Spawn({loadgen, "--socket", socket_path, "--connections", "4", "--requests", "20000", "--pipeline", "64"});
+        CHECK(pid > 0);
+        if (pid > 0) {
+            CHECK(Wait(pid) == 0);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: run_server_tests SERVER_BINARY LOADGEN_BINARY\n");
+        return 2;
+    }
+    if (voprf_init() != 0) {
+        std::fprintf(stderr, "voprf_init failed\n");
+        return 1;
+    }
+
+    TempPath key_path("key");
+    TempPath socket_path("sock");
+    voprf_private_key_t* sk = nullptr;
+    CHECK_OK(voprf_private_key_generate(&sk));
+    uint8_t key[VOPRF_PRIVATE_KEY_BYTES];
+    CHECK_OK(voprf_private_key_to_bytes(sk, key, sizeof(key)));
+    FILE* f = std::fopen(key_path.path.c_str(), "wb");
+    CHECK(f && std::fwrite(key, 1, sizeof(key), f) == sizeof(key));
+    if (f) {
+        std::fclose(f);
+    }
+    Pool pool;
+    MakePool(sk, pool);
+    voprf_private_key_destroy(sk);
+
+    pid_t server = Spawn({argv[1], "--key", key_path.path, "--socket", socket_path.path, "--workers", "2"});
+    CHECK(server > 0);
+    if (server > 0) {
+        TestResponses(socket_path.path, pool);
+        TestMalformedFrame(socket_path.path);
+        TestBackpressure(socket_path.path, pool);
+        TestLoadgen(argv[2], socket_path.path);
+
+        kill(server, SIGTERM);
+        CHECK(Wait(server) == 0);
+        CHECK(access(socket_path.path.c_str(), F_OK) != 0);
+    }
+    TestIdleBatches(argv[1], key_path.path, pool);
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all server tests passed\n");
+    return 0;
+}
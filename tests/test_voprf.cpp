@@ -0,0 +1,1043 @@
+// Tests for the public C API.
+//
+// Each test is a function registered in main(). CHECK records a failure and
+// carries on, so one run reports every broken expectation; the process exits
+// non-zero if any check failed.
+
+#include "voprf/voprf.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VOPRF_TEST_POSIX 1
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#endif
+
+namespace {
+    int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                             \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_OK(expr) CHECK((expr) == 0)
+
+    // A server key pair for the duration of one test.
+    struct Keys {
+        voprf_private_key_t* sk = nullptr;
+        voprf_public_key_t* pk = nullptr;
+
+        Keys() {
+            CHECK_OK(voprf_private_key_generate(&sk));
+            CHECK_OK(voprf_private_key_get_public_key(sk, &pk));
+        }
+
+        ~Keys() {
+            voprf_public_key_destroy(pk);
+            voprf_private_key_destroy(sk);
+        }
+    };
+
+    // The messages "msg 0", "msg 1", ... with pointer and length arrays for
+    // the batch APIs.
+    struct Messages {
+        std::vector<std::string> text;
+        std::vector<const uint8_t*> ptrs;
+        std::vector<size_t> lens;
+
+        explicit Messages(size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                text.push_back("msg " + std::to_string(i));
+            }
+            for (const auto& t : text) {
+                ptrs.push_back(reinterpret_cast<const uint8_t*>(t.data()));
+                lens.push_back(t.size());
+            }
+        }
+    };
+
+    // Runs the full protocol for msg and returns the OPRF output.
+    voprf_point_t* Oprf(const Keys& keys, const std::string& msg) {
+        voprf_private_key_t* r = nullptr;
+        voprf_point_t* blinded = nullptr;
+        voprf_point_t* evaluated = nullptr;
+        voprf_point_t* output = nullptr;
+        CHECK_OK(voprf_blind(reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), &r, &blinded));
+        CHECK_OK(voprf_evaluate(keys.sk, blinded, &evaluated));
+        CHECK_OK(voprf_unblind(evaluated, r, &output));
+        voprf_point_destroy(evaluated);
+        voprf_point_destroy(blinded);
+        voprf_private_key_destroy(r);
+        return output;
+    }
+
+    // Verifies outputs for msgs where the entries listed in bad are replaced
+    // by the output of another message, and checks that exactly those
+    // entries are reported invalid.
+    void CheckVerifyBatch(size_t n, const std::vector<size_t>& bad) {
+        Keys keys;
+        Messages msgs(n);
+        std::vector<voprf_point_t*> outputs(n);
+        for (size_t i = 0; i < n; i++) {
+            outputs[i] = Oprf(keys, msgs.text[i]);
+        }
+        std::vector<bool> expected(n, true);
+        for (size_t i : bad) {
+            voprf_point_destroy(outputs[i]);
+            outputs[i] = Oprf(keys, "forged " + std::to_string(i));
+            expected[i] = false;
+        }
+
+        std::vector<const voprf_point_t*> views(outputs.begin(), outputs.end());
+        bool results[64];
+        bool all_valid = !bad.empty();
+        CHECK_OK(voprf_verify_batch(keys.pk, msgs.ptrs.data(), msgs.lens.data(), views.data(), n, results, &all_valid, 0));
+        CHECK(all_valid == bad.empty());
+        for (size_t i = 0; i < n; i++) {
+            CHECK(results[i] == expected[i]);
+        }
+
+        // Without a results array only the combined verdict is computed.
+        all_valid = !bad.empty();
+        CHECK_OK(voprf_verify_batch(keys.pk, msgs.ptrs.data(), msgs.lens.data(), views.data(), n, nullptr, &all_valid, 1));
+        CHECK(all_valid == bad.empty());
+
+        for (auto* p : outputs) {
+            voprf_point_destroy(p);
+        }
+    }
+
+    void TestVerifyBatch() {
+        CheckVerifyBatch(13, {});
+        CheckVerifyBatch(13, {2, 7, 8, 12});
+        CheckVerifyBatch(13, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+        CheckVerifyBatch(13, {0});
+        CheckVerifyBatch(13, {12});
+        CheckVerifyBatch(13, {6});
+        CheckVerifyBatch(1, {0});
+        CheckVerifyBatch(1, {});
+    }
+
+    bool SameKey(const voprf_private_key_t* a, const voprf_private_key_t* b) {
+        uint8_t x[VOPRF_PRIVATE_KEY_BYTES];
+        uint8_t y[VOPRF_PRIVATE_KEY_BYTES];
+        return voprf_private_key_to_bytes(a, x, sizeof(x)) == 0 &&
+               voprf_private_key_to_bytes(b, y, sizeof(y)) == 0 &&
+               memcmp(x, y, sizeof(x)) == 0;
+    }
+
+    bool SamePublicKey(const voprf_public_key_t* a, const voprf_public_key_t* b) {
+        uint8_t x[VOPRF_PUBLIC_KEY_BYTES];
+        uint8_t y[VOPRF_PUBLIC_KEY_BYTES];
+        return voprf_public_key_to_bytes(a, x, sizeof(x)) == 0 &&
+               voprf_public_key_to_bytes(b, y, sizeof(y)) == 0 &&
+               memcmp(x, y, sizeof(x)) == 0;
+    }
+
+    bool SamePoint(const voprf_point_t* a, const voprf_point_t* b) {
+        bool equal = false;
+        return voprf_point_equal(a, b, &equal) == 0 && equal;
+    }
+
+    voprf_point_t* Blind(const std::string& msg) {
+        voprf_private_key_t* r = nullptr;
+        voprf_point_t* blinded = nullptr;
+        CHECK_OK(voprf_blind(reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), &r, &blinded));
+        voprf_private_key_destroy(r);
+        return blinded;
+    }
+
+    // A proof is rejected either by a false result or by an error, e.g.
+    // when tampered proof bytes no longer decode.
+    bool ProofAccepted(const voprf_point_t* proof_key, const voprf_point_t* blinded, const voprf_point_t* evaluated, const uint8_t* proof, size_t proof_len) {
+        bool result = false;
+        return voprf_verify_proof(proof_key, blinded, evaluated, proof, proof_len, &result) == 0 && result;
+    }
+
+    void TestDleqProof() {
+        Keys keys;
+        Keys other;
+        voprf_point_t* proof_key = nullptr;
+        voprf_point_t* other_proof_key = nullptr;
+        CHECK_OK(voprf_private_key_get_proof_key(keys.sk, &proof_key));
+        CHECK_OK(voprf_private_key_get_proof_key(other.sk, &other_proof_key));
+
+        voprf_point_t* blinded = Blind("dleq");
+        voprf_point_t* other_blinded = Blind("dleq other");
+        voprf_point_t* evaluated = nullptr;
+        voprf_point_t* other_evaluated = nullptr;
+        uint8_t proof[VOPRF_PROOF_BYTES];
+        CHECK_OK(voprf_evaluate_with_proof(keys.sk, blinded, &evaluated, proof, sizeof(proof)));
+        CHECK_OK(voprf_evaluate(keys.sk, other_blinded, &other_evaluated));
+
+        CHECK(ProofAccepted(proof_key, blinded, evaluated, proof, sizeof(proof)));
+
+        // Any change to the proof, the key or either point is caught.
+        for (size_t i : {size_t(0), size_t(VOPRF_PROOF_BYTES / 2), size_t(VOPRF_PROOF_BYTES - 1)}) {
+            uint8_t tampered[VOPRF_PROOF_BYTES];
+            memcpy(tampered, proof, sizeof(proof));
+            tampered[i] ^= 0x01;
+            CHECK(!ProofAccepted(proof_key, blinded, evaluated, tampered, sizeof(tampered)));
+        }
+        CHECK(!ProofAccepted(other_proof_key, blinded, evaluated, proof, sizeof(proof)));
+        CHECK(!ProofAccepted(proof_key, other_blinded, evaluated, proof, sizeof(proof)));
+        CHECK(!ProofAccepted(proof_key, blinded, other_evaluated, proof, sizeof(proof)));
+        CHECK(!ProofAccepted(proof_key, blinded, evaluated, proof, sizeof(proof) - 1));
+
+        // The same evaluation by another key does not verify under this key.
+        voprf_point_t* forged = nullptr;
+        uint8_t forged_proof[VOPRF_PROOF_BYTES];
+        CHECK_OK(voprf_evaluate_with_proof(other.sk, blinded, &forged, forged_proof, sizeof(forged_proof)));
+        CHECK(!ProofAccepted(proof_key, blinded, forged, forged_proof, sizeof(forged_proof)));
+        CHECK(ProofAccepted(other_proof_key, blinded, forged, forged_proof, sizeof(forged_proof)));
+
+        // The prepared context proves against the same proof key.
+        voprf_server_ctx_t* ctx = nullptr;
+        voprf_point_t* ctx_proof_key = nullptr;
+        voprf_point_t* ctx_evaluated = nullptr;
+        uint8_t ctx_proof[VOPRF_PROOF_BYTES];
+        CHECK_OK(voprf_server_ctx_create(keys.sk, &ctx));
+        CHECK_OK(voprf_server_ctx_get_proof_key(ctx, &ctx_proof_key));
+        CHECK(SamePoint(ctx_proof_key, proof_key));
+        CHECK_OK(voprf_server_ctx_evaluate_with_proof(ctx, blinded, &ctx_evaluated, ctx_proof, sizeof(ctx_proof)));
+        CHECK(SamePoint(ctx_evaluated, evaluated));
+        CHECK(ProofAccepted(proof_key, blinded, ctx_evaluated, ctx_proof, sizeof(ctx_proof)));
+
+        voprf_point_destroy(ctx_evaluated);
+        voprf_point_destroy(ctx_proof_key);
+        voprf_server_ctx_destroy(ctx);
+        voprf_point_destroy(forged);
+        voprf_point_destroy(other_evaluated);
+        voprf_point_destroy(evaluated);
+        voprf_point_destroy(other_blinded);
+        voprf_point_destroy(blinded);
+        voprf_point_destroy(other_proof_key);
+        voprf_point_destroy(proof_key);
+    }
+
+    bool BatchProofAccepted(const voprf_point_t* proof_key, const std::vector<voprf_point_t*>& blinded, const std::vector<voprf_point_t*>& evaluated, const uint8_t* proof, size_t proof_len) {
+        bool result = false;
+        return voprf_verify_proof_batch(proof_key, blinded.data(), evaluated.data(), blinded.size(), proof, proof_len, &result) == 0 && result;
+    }
+
+    void CheckBatchDleqProof(const voprf_server_ctx_t* ctx, const voprf_point_t* proof_key, size_t n) {
+        std::vector<voprf_point_t*> blinded(n);
+        std::vector<voprf_point_t*> evaluated(n, nullptr);
+        for (size_t i = 0; i < n; i++) {
+            blinded[i] = Blind("batch dleq " + std::to_string(i));
+        }
+        uint8_t proof[VOPRF_PROOF_BYTES];
+        CHECK_OK(voprf_server_ctx_evaluate_batch_with_proof(ctx, blinded.data(), n, evaluated.data(), 2, proof, sizeof(proof)));
+        CHECK(BatchProofAccepted(proof_key, blinded, evaluated, proof, sizeof(proof)));
+
+        // Replacing any one evaluated point breaks the proof, whether with
+        // an evaluation of another input or with a neighbour's output.
+        voprf_point_t* stray_blinded = Blind("batch dleq stray");
+        voprf_point_t* stray = nullptr;
+        CHECK_OK(voprf_server_ctx_evaluate(ctx, stray_blinded, &stray));
+        for (size_t i = 0; i < n; i++) {
+            std::vector<voprf_point_t*> swapped = evaluated;
+            swapped[i] = stray;
+            CHECK(!BatchProofAccepted(proof_key, blinded, swapped, proof, sizeof(proof)));
+            if (n > 1) {
+                swapped[i] = evaluated[(i + 1) % n];
+                CHECK(!BatchProofAccepted(proof_key, blinded, swapped, proof, sizeof(proof)));
+            }
+        }
+
+        // A single-point batch proves exactly what voprf_verify_proof checks.
+        if (n == 1) {
+            CHECK(ProofAccepted(proof_key, blinded[0], evaluated[0], proof, sizeof(proof)));
+        }
+
+        voprf_point_destroy(stray);
+        voprf_point_destroy(stray_blinded);
+        for (size_t i = 0; i < n; i++) {
+            voprf_point_destroy(evaluated[i]);
+            voprf_point_destroy(blinded[i]);
+        }
+    }
+
+    void TestBatchDleqProof() {
+        Keys keys;
+        voprf_server_ctx_t* ctx = nullptr;
+        voprf_point_t* proof_key = nullptr;
+        CHECK_OK(voprf_server_ctx_create(keys.sk, &ctx));
+        CHECK_OK(voprf_server_ctx_get_proof_key(ctx, &proof_key));
+
+        CheckBatchDleqProof(ctx, proof_key, 1);
+        CheckBatchDleqProof(ctx, proof_key, 2);
+        CheckBatchDleqProof(ctx, proof_key, 9);
+
+        // An empty batch is rejected on both sides rather than producing or
+        // accepting a proof about nothing.
+        voprf_point_t* blinded = Blind("batch dleq empty");
+        voprf_point_t* evaluated = nullptr;
+        uint8_t proof[VOPRF_PROOF_BYTES];
+        bool result = true;
+        CHECK(voprf_server_ctx_evaluate_batch_with_proof(ctx, &blinded, 0, &evaluated, 1, proof, sizeof(proof)) != 0);
+        CHECK(evaluated == nullptr);
+        CHECK_OK(voprf_server_ctx_evaluate_with_proof(ctx, blinded, &evaluated, proof, sizeof(proof)));
+        CHECK(voprf_verify_proof_batch(proof_key, &blinded, &evaluated, 0, proof, sizeof(proof), &result) != 0);
+
+        voprf_point_destroy(evaluated);
+        voprf_point_destroy(blinded);
+        voprf_point_destroy(proof_key);
+        voprf_server_ctx_destroy(ctx);
+    }
+
+    // Point objects in caller-provided storage, as the batch
+    // deserialization API expects.
+    struct PointArray {
+        std::vector<unsigned char> storage;
+        voprf_point_t* points = nullptr;
+        size_t n;
+
+        explicit PointArray(size_t n): storage(n * voprf_point_sizeof() + voprf_point_alignof()), n(n) {
+            void* aligned = storage.data();
+            size_t space = storage.size();
+            std::align(voprf_point_alignof(), n * voprf_point_sizeof(), aligned, space);
+            CHECK_OK(voprf_point_array_init(aligned, space, n, &points));
+        }
+
+        ~PointArray() {
+            voprf_point_array_deinit(points, n);
+        }
+
+        voprf_point_t* operator[](size_t i) {
+            return voprf_point_array_at(points, i);
+        }
+    };
+
+    // Nudges the middle byte of a compressed encoding until its x coordinate
+    // has no point on the curve.
+    void BreakCompressed(uint8_t* encoding) {
+        const size_t mid = VOPRF_POINT_BYTES / 2;
+        const uint8_t original = encoding[mid];
+        for (unsigned k = 1; k < 256; k++) {
+            encoding[mid] = static_cast<uint8_t>(original ^ k);
+            voprf_point_t* p = nullptr;
+            if (voprf_point_from_bytes(&p, encoding, VOPRF_POINT_BYTES) != 0) {
+                return;
+            }
+            voprf_point_destroy(p);
+        }
+        std::fprintf(stderr, "%s:%d: no off-curve x found\n", __FILE__, __LINE__);
+        failures++;
+    }
+
+    void TestPointsFromBytes() {
+        const size_t n = 11;
+        std::vector<voprf_point_t*> points(n);
+        std::vector<uint8_t> buf(n * VOPRF_POINT_BYTES);
+        for (size_t i = 0; i < n; i++) {
+            points[i] = Blind("decode " + std::to_string(i));
+            CHECK_OK(voprf_point_to_bytes(points[i], &buf[i * VOPRF_POINT_BYTES], VOPRF_POINT_BYTES));
+        }
+
+        for (voprf_validation mode : {VOPRF_VALIDATE_STRICT, VOPRF_VALIDATE_TRUSTED}) {
+            PointArray decoded(n);
+            CHECK_OK(voprf_points_from_bytes(buf.data(), buf.size(), n, VOPRF_FORMAT_COMPRESSED, decoded.points, mode, 3, nullptr));
+            for (size_t i = 0; i < n; i++) {
+                CHECK(SamePoint(decoded[i], points[i]));
+            }
+        }
+
+        // Off-curve points are rejected in either mode, since decoding a
+        // compressed point solves the curve equation, and the first bad
+        // index is reported whichever thread finds it.
+        std::vector<uint8_t> bad = buf;
+        BreakCompressed(&bad[7 * VOPRF_POINT_BYTES]);
+        BreakCompressed(&bad[4 * VOPRF_POINT_BYTES]);
+        for (voprf_validation mode : {VOPRF_VALIDATE_STRICT, VOPRF_VALIDATE_TRUSTED}) {
+            PointArray decoded(n);
+            size_t failed_index = SIZE_MAX;
+            CHECK(voprf_points_from_bytes(bad.data(), bad.size(), n, VOPRF_FORMAT_COMPRESSED, decoded.points, mode, 3, &failed_index) != 0);
+            CHECK(failed_index == 4);
+        }
+        voprf_point_t* single = nullptr;
+        CHECK(voprf_point_from_bytes(&single, &bad[4 * VOPRF_POINT_BYTES], VOPRF_POINT_BYTES) != 0);
+
+        // A buffer shorter than n points or an unknown mode is rejected
+        // before anything is decoded; n = 0 decodes nothing.
+        PointArray decoded(n);
+        CHECK(voprf_points_from_bytes(buf.data(), buf.size() - 1, n, VOPRF_FORMAT_COMPRESSED, decoded.points, VOPRF_VALIDATE_STRICT, 1, nullptr) != 0);
+        CHECK(voprf_points_from_bytes(buf.data(), buf.size(), n, VOPRF_FORMAT_COMPRESSED, decoded.points, static_cast<voprf_validation>(7), 1, nullptr) != 0);
+        CHECK_OK(voprf_points_from_bytes(buf.data(), 0, 0, VOPRF_FORMAT_COMPRESSED, decoded.points, VOPRF_VALIDATE_STRICT, 1, nullptr));
+
+        for (auto* p : points) {
+            voprf_point_destroy(p);
+        }
+    }
+
+    // Decodes a tagged point into a scratch object and compares it with p.
+    bool TaggedDecodesTo(const uint8_t* buf, size_t len, voprf_validation mode, const voprf_point_t* p) {
+        voprf_point_t* decoded = Blind("scratch");
+        bool same = voprf_point_from_tagged_bytes_into(decoded, buf, len, mode) == 0 && SamePoint(decoded, p);
+        voprf_point_destroy(decoded);
+        return same;
+    }
+
+    void TestTaggedPoints() {
+        voprf_point_t* p = Blind("tagged");
+        voprf_point_t* scratch = Blind("tagged scratch");
+        uint8_t plain[VOPRF_POINT_BYTES];
+        CHECK_OK(voprf_point_to_bytes(p, plain, sizeof(plain)));
+
+        for (voprf_format format : {VOPRF_FORMAT_COMPRESSED, VOPRF_FORMAT_UNCOMPRESSED}) {
+            const size_t size = VOPRF_POINT_TAGGED_BYTES(format);
+            std::vector<uint8_t> buf(size);
+            CHECK(voprf_point_to_tagged_bytes(p, format, buf.data(), size - 1) != 0);
+            CHECK_OK(voprf_point_to_tagged_bytes(p, format, buf.data(), size));
+            CHECK(buf[0] == format);
+            CHECK(TaggedDecodesTo(buf.data(), size, VOPRF_VALIDATE_STRICT, p));
+            CHECK(TaggedDecodesTo(buf.data(), size, VOPRF_VALIDATE_TRUSTED, p));
+            if (format == VOPRF_FORMAT_COMPRESSED) {
+                // The compressed payload is the default encoding.
+                CHECK(memcmp(buf.data() + 1, plain, sizeof(plain)) == 0);
+            }
+
+            // Truncated encodings, including an empty one, are rejected.
+            CHECK(voprf_point_from_tagged_bytes_into(scratch, buf.data(), size - 1, VOPRF_VALIDATE_STRICT) != 0);
+            CHECK(voprf_point_from_tagged_bytes_into(scratch, buf.data(), 1, VOPRF_VALIDATE_STRICT) != 0);
+            CHECK(voprf_point_from_tagged_bytes_into(scratch, buf.data(), 0, VOPRF_VALIDATE_STRICT) != 0);
+
+            // So are tags that name no format.
+            for (uint8_t tag : {0x00, 0x03, 0xff}) {
+                std::vector<uint8_t> bad = buf;
+                bad[0] = tag;
+                CHECK(voprf_point_from_tagged_bytes_into(scratch, bad.data(), bad.size(), VOPRF_VALIDATE_STRICT) != 0);
+            }
+        }
+
+        // A compressed payload under the uncompressed tag is too short.
+        uint8_t compressed[VOPRF_POINT_TAGGED_BYTES(VOPRF_FORMAT_COMPRESSED)];
+        CHECK_OK(voprf_point_to_tagged_bytes(p, VOPRF_FORMAT_COMPRESSED, compressed, sizeof(compressed)));
+        compressed[0] = VOPRF_FORMAT_UNCOMPRESSED;
+        CHECK(voprf_point_from_tagged_bytes_into(scratch, compressed, sizeof(compressed), VOPRF_VALIDATE_STRICT) != 0);
+
+        // Off the curve: a tampered y fails the curve equation check, and an
+        // x without a matching y fails to decompress.
+        uint8_t uncompressed[VOPRF_POINT_TAGGED_BYTES(VOPRF_FORMAT_UNCOMPRESSED)];
+        CHECK_OK(voprf_point_to_tagged_bytes(p, VOPRF_FORMAT_UNCOMPRESSED, uncompressed, sizeof(uncompressed)));
+        uncompressed[1 + VOPRF_POINT_BYTES + VOPRF_POINT_BYTES / 2] ^= 0x01;
+        CHECK(voprf_point_from_tagged_bytes_into(scratch, uncompressed, sizeof(uncompressed), VOPRF_VALIDATE_STRICT) != 0);
+        CHECK_OK(voprf_point_to_tagged_bytes(p, VOPRF_FORMAT_COMPRESSED, compressed, sizeof(compressed)));
+        BreakCompressed(compressed + 1);
+        CHECK(voprf_point_from_tagged_bytes_into(scratch, compressed, sizeof(compressed), VOPRF_VALIDATE_STRICT) != 0);
+
+        // Unknown formats and modes are argument errors.
+        CHECK(voprf_point_to_tagged_bytes(p, static_cast<voprf_format>(0), uncompressed, sizeof(uncompressed)) != 0);
+        CHECK_OK(voprf_point_to_tagged_bytes(p, VOPRF_FORMAT_COMPRESSED, compressed, sizeof(compressed)));
+        CHECK(voprf_point_from_tagged_bytes_into(scratch, compressed, sizeof(compressed), static_cast<voprf_validation>(7)) != 0);
+
+        voprf_point_destroy(scratch);
+        voprf_point_destroy(p);
+    }
+
+    void TestTaggedPublicKeys() {
+        Keys keys;
+        Keys scratch;
+        uint8_t plain[VOPRF_PUBLIC_KEY_BYTES];
+        CHECK_OK(voprf_public_key_to_bytes(keys.pk, plain, sizeof(plain)));
+        voprf_public_key_t* decoded = nullptr;
+        CHECK_OK(voprf_public_key_from_bytes(&decoded, plain, sizeof(plain)));
+        CHECK(SamePublicKey(decoded, keys.pk));
+        voprf_public_key_destroy(decoded);
+        CHECK(voprf_public_key_from_bytes(&decoded, plain, sizeof(plain) - 1) != 0);
+
+        for (voprf_format format : {VOPRF_FORMAT_COMPRESSED, VOPRF_FORMAT_UNCOMPRESSED}) {
+            const size_t size = VOPRF_PUBLIC_KEY_TAGGED_BYTES(format);
+            std::vector<uint8_t> buf(size);
+            CHECK(voprf_public_key_to_tagged_bytes(keys.pk, format, buf.data(), size - 1) != 0);
+            CHECK_OK(voprf_public_key_to_tagged_bytes(keys.pk, format, buf.data(), size));
+            CHECK(buf[0] == format);
+            for (voprf_validation mode : {VOPRF_VALIDATE_STRICT, VOPRF_VALIDATE_TRUSTED}) {
+                CHECK_OK(voprf_public_key_from_tagged_bytes_into(scratch.pk, buf.data(), size, mode));
+                CHECK(SamePublicKey(scratch.pk, keys.pk));
+            }
+            if (format == VOPRF_FORMAT_COMPRESSED) {
+                CHECK(memcmp(buf.data() + 1, plain, sizeof(plain)) == 0);
+            }
+
+            CHECK(voprf_public_key_from_tagged_bytes_into(scratch.pk, buf.data(), size - 1, VOPRF_VALIDATE_STRICT) != 0);
+            CHECK(voprf_public_key_from_tagged_bytes_into(scratch.pk, buf.data(), 0, VOPRF_VALIDATE_STRICT) != 0);
+            for (uint8_t tag : {0x00, 0x03, 0xff}) {
+                std::vector<uint8_t> bad = buf;
+                bad[0] = tag;
+                CHECK(voprf_public_key_from_tagged_bytes_into(scratch.pk, bad.data(), bad.size(), VOPRF_VALIDATE_STRICT) != 0);
+            }
+        }
+
+        // A tampered y coordinate puts the key off the curve.
+        uint8_t uncompressed[VOPRF_PUBLIC_KEY_TAGGED_BYTES(VOPRF_FORMAT_UNCOMPRESSED)];
+        CHECK_OK(voprf_public_key_to_tagged_bytes(keys.pk, VOPRF_FORMAT_UNCOMPRESSED, uncompressed, sizeof(uncompressed)));
+        uncompressed[1 + VOPRF_PUBLIC_KEY_BYTES + VOPRF_PUBLIC_KEY_BYTES / 4] ^= 0x01;
+        CHECK(voprf_public_key_from_tagged_bytes_into(scratch.pk, uncompressed, sizeof(uncompressed), VOPRF_VALIDATE_STRICT) != 0);
+    }
+
+    void TestPointsToBytes() {
+        const size_t n = 10;
+        std::vector<voprf_point_t*> points(n);
+        for (size_t i = 0; i < n; i++) {
+            points[i] = Blind("encode " + std::to_string(i));
+        }
+        std::vector<const voprf_point_t*> views(points.begin(), points.end());
+
+        // Compressed output is the concatenation of the single-point
+        // encodings and decodes back in one batch.
+        std::vector<uint8_t> compressed(n * VOPRF_POINT_BYTES);
+        CHECK(voprf_points_to_bytes(views.data(), n, VOPRF_FORMAT_COMPRESSED, compressed.data(), compressed.size() - 1, 2) != 0);
+        CHECK_OK(voprf_points_to_bytes(views.data(), n, VOPRF_FORMAT_COMPRESSED, compressed.data(), compressed.size(), 2));
+        PointArray decoded(n);
+        CHECK_OK(voprf_points_from_bytes(compressed.data(), compressed.size(), n, VOPRF_FORMAT_COMPRESSED, decoded.points, VOPRF_VALIDATE_STRICT, 2, nullptr));
+        for (size_t i = 0; i < n; i++) {
+            uint8_t single[VOPRF_POINT_BYTES];
+            CHECK_OK(voprf_point_to_bytes(points[i], single, sizeof(single)));
+            CHECK(memcmp(&compressed[i * VOPRF_POINT_BYTES], single, sizeof(single)) == 0);
+            CHECK(SamePoint(decoded[i], points[i]));
+        }
+
+        // Uncompressed records match the payload of the tagged encoding.
+        std::vector<uint8_t> uncompressed(n * VOPRF_POINT_UNCOMPRESSED_BYTES);
+        CHECK_OK(voprf_points_to_bytes(views.data(), n, VOPRF_FORMAT_UNCOMPRESSED, uncompressed.data(), uncompressed.size(), 0));
+        for (size_t i = 0; i < n; i++) {
+            uint8_t tagged[VOPRF_POINT_TAGGED_BYTES(VOPRF_FORMAT_UNCOMPRESSED)];
+            tagged[0] = VOPRF_FORMAT_UNCOMPRESSED;
+            memcpy(tagged + 1, &uncompressed[i * VOPRF_POINT_UNCOMPRESSED_BYTES], VOPRF_POINT_UNCOMPRESSED_BYTES);
+            CHECK(TaggedDecodesTo(tagged, sizeof(tagged), VOPRF_VALIDATE_STRICT, points[i]));
+        }
+
+        // And the uncompressed batch reads back in one call in either mode.
+        for (voprf_validation mode : {VOPRF_VALIDATE_STRICT, VOPRF_VALIDATE_TRUSTED}) {
+            PointArray batch(n);
+            CHECK_OK(voprf_points_from_bytes(uncompressed.data(), uncompressed.size(), n, VOPRF_FORMAT_UNCOMPRESSED, batch.points, mode, 2, nullptr));
+            for (size_t i = 0; i < n; i++) {
+                CHECK(SamePoint(batch[i], points[i]));
+            }
+        }
+
+        // Strict mode rejects an uncompressed record whose y is not on the
+        // curve; a buffer sized for compressed points is too short, and an
+        // unknown format is an argument error.
+        std::vector<uint8_t> bad = uncompressed;
+        bad[6 * VOPRF_POINT_UNCOMPRESSED_BYTES + VOPRF_POINT_BYTES + VOPRF_POINT_BYTES / 2] ^= 0x01;
+        size_t failed_index = SIZE_MAX;
+        CHECK(voprf_points_from_bytes(bad.data(), bad.size(), n, VOPRF_FORMAT_UNCOMPRESSED, decoded.points, VOPRF_VALIDATE_STRICT, 2, &failed_index) != 0);
+        CHECK(failed_index == 6);
+        CHECK(voprf_points_from_bytes(compressed.data(), compressed.size(), n, VOPRF_FORMAT_UNCOMPRESSED, decoded.points, VOPRF_VALIDATE_STRICT, 2, nullptr) != 0);
+        CHECK(voprf_points_from_bytes(compressed.data(), compressed.size(), n, static_cast<voprf_format>(0), decoded.points, VOPRF_VALIDATE_STRICT, 2, nullptr) != 0);
+
+        for (auto* p : points) {
+            voprf_point_destroy(p);
+        }
+    }
+
+    // Private key objects in caller-provided storage, to receive the
+    // blinding factors of an engine BLIND job.
+    struct KeyArray {
+        std::vector<unsigned char> storage;
+        voprf_private_key_t* keys = nullptr;
+        size_t n;
+
+        explicit KeyArray(size_t n): storage(n * voprf_private_key_sizeof() + voprf_private_key_alignof()), n(n) {
+            void* aligned = storage.data();
+            size_t space = storage.size();
+            std::align(voprf_private_key_alignof(), n * voprf_private_key_sizeof(), aligned, space);
+            CHECK_OK(voprf_private_key_array_init(aligned, space, n, &keys));
+        }
+
+        ~KeyArray() {
+            voprf_private_key_array_deinit(keys, n);
+        }
+
+        voprf_private_key_t* operator[](size_t i) {
+            return voprf_private_key_array_at(keys, i);
+        }
+    };
+
+    // Element pointers into a PointArray, in the shapes a job takes.
+    std::vector<voprf_point_t*> Outputs(PointArray& array) {
+        std::vector<voprf_point_t*> out(array.n);
+        for (size_t i = 0; i < array.n; i++) {
+            out[i] = array[i];
+        }
+        return out;
+    }
+
+    std::vector<const voprf_point_t*> Inputs(PointArray& array) {
+        std::vector<const voprf_point_t*> in(array.n);
+        for (size_t i = 0; i < array.n; i++) {
+            in[i] = array[i];
+        }
+        return in;
+    }
+
+    // Records callback completions. While held, a callback waits before
+    // recording, which keeps the worker that runs it busy.
+    struct Callbacks {
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool held = false;
+        size_t waiting = 0;
+        std::vector<voprf_job_completion_t> done;
+
+        static void Record(void* user_data, uint64_t job_id, int status) {
+            Callbacks* self = static_cast<Callbacks*>(user_data);
+            std::unique_lock<std::mutex> lock(self->mutex);
+            self->waiting++;
+            self->changed.notify_all();
+            self->changed.wait(lock, [self] { return !self->held; });
+            self->waiting--;
+            self->done.push_back({job_id, status, user_data});
+            self->changed.notify_all();
+        }
+
+        void Hold() {
+            std::lock_guard<std::mutex> lock(mutex);
+            held = true;
+        }
+
+        void Release() {
+            std::lock_guard<std::mutex> lock(mutex);
+            held = false;
+            changed.notify_all();
+        }
+
+        void WaitForBlocked() {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return waiting > 0; });
+        }
+
+        // Waits for the n-th completion and returns it.
+        voprf_job_completion_t WaitFor(size_t n) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this, n] { return done.size() >= n; });
+            return done[n - 1];
+        }
+    };
+
+    // Waits for the next completion record; the engine has no blocking poll.
+    voprf_job_completion_t PollOne(voprf_engine_t* engine) {
+        voprf_job_completion_t completion = {0, -1, nullptr};
+        size_t count = 0;
+        while (voprf_engine_poll(engine, &completion, 1, &count) == 0 && count == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(count == 1);
+        return completion;
+    }
+
+    // Waits until no items are outstanding. A job without a callback posts
+    // its record before releasing its items, so every record is queued by
+    // then.
+    void WaitIdle(voprf_engine_t* engine) {
+        size_t pending = 0;
+        while (voprf_engine_pending(engine, &pending) == 0 && pending != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    voprf_job_t EvaluateJob(const voprf_server_ctx_t* ctx, const std::vector<const voprf_point_t*>& in, const std::vector<voprf_point_t*>& out, size_t n) {
+        voprf_job_t job;
+        memset(&job, 0, sizeof(job));
+        job.type = VOPRF_JOB_EVALUATE;
+        job.n = n;
+        job.ctx = ctx;
+        job.points = in.data();
+        job.out_points = out.data();
+        return job;
+    }
+
+#ifdef __linux__
+    bool Readable(int fd) {
+        pollfd p = {fd, POLLIN, 0};
+        return poll(&p, 1, 0) == 1 && (p.revents & POLLIN) != 0;
+    }
+
+    // The eventfd is readable exactly while completion records are waiting.
+    void CheckEngineFd(const voprf_server_ctx_t* ctx, const std::vector<const voprf_point_t*>& in, PointArray& out) {
+        voprf_engine_t* engine = nullptr;
+        CHECK_OK(voprf_engine_create(2, 0, &engine));
+        int fd = -1;
+        CHECK_OK(voprf_engine_get_fd(engine, &fd));
+        CHECK(fd >= 0);
+        CHECK(!Readable(fd));
+
+        // Two jobs writing disjoint outputs, so that they can run at once.
+        std::vector<voprf_point_t*> out_points = Outputs(out);
+        std::vector<voprf_point_t*> more_points(out_points.begin() + 3, out_points.end());
+        voprf_job_t job = EvaluateJob(ctx, in, out_points, 3);
+        voprf_job_t more = EvaluateJob(ctx, in, more_points, 3);
+        uint64_t ids[2] = {0, 0};
+        CHECK_OK(voprf_engine_submit(engine, &job, &ids[0]));
+        CHECK_OK(voprf_engine_submit(engine, &more, &ids[1]));
+        CHECK(ids[0] != ids[1]);
+        WaitIdle(engine);
+
+        CHECK(Readable(fd));
+        voprf_job_completion_t completions[4];
+        size_t count = 0;
+        CHECK_OK(voprf_engine_poll(engine, completions, 1, &count));
+        CHECK(count == 1);
+        CHECK(Readable(fd));
+        CHECK_OK(voprf_engine_poll(engine, completions + 1, 3, &count));
+        CHECK(count == 1);
+        CHECK(!Readable(fd));
+        CHECK((completions[0].job_id == ids[0] && completions[1].job_id == ids[1]) ||
+              (completions[0].job_id == ids[1] && completions[1].job_id == ids[0]));
+        CHECK(completions[0].status == 0 && completions[1].status == 0);
+
+        voprf_engine_destroy(engine);
+    }
+#endif
+
+    // With one worker held in a callback, admitted items stay pending:
+    // try_submit turns a job away once it would exceed max_pending, and a
+    // job larger than the bound gets in only when the engine is empty.
+    void CheckEngineBackpressure(const voprf_server_ctx_t* ctx, const std::vector<const voprf_point_t*>& in, PointArray& out, PointArray& expected) {
+        const size_t max_pending = 4;
+        const size_t oversized = 10;
+        Callbacks callbacks;
+        voprf_engine_t* engine = nullptr;
+        CHECK_OK(voprf_engine_create(1, max_pending, &engine));
+        std::vector<voprf_point_t*> out_points = Outputs(out);
+
+        voprf_job_t blocker = EvaluateJob(ctx, in, out_points, 1);
+        blocker.callback = Callbacks::Record;
+        blocker.user_data = &callbacks;
+        uint64_t blocker_id = 0;
+        callbacks.Hold();
+        CHECK_OK(voprf_engine_submit(engine, &blocker, &blocker_id));
+        callbacks.WaitForBlocked();
+
+        voprf_job_t fill = EvaluateJob(ctx, in, out_points, max_pending);
+        uint64_t fill_id = 0;
+        bool accepted = false;
+        CHECK_OK(voprf_engine_try_submit(engine, &fill, &fill_id, &accepted));
+        CHECK(accepted);
+        size_t pending = 0;
+        CHECK_OK(voprf_engine_pending(engine, &pending));
+        CHECK(pending == max_pending);
+
+        voprf_job_t one = EvaluateJob(ctx, in, out_points, 1);
+        uint64_t id = 0;
+        accepted = true;
+        CHECK_OK(voprf_engine_try_submit(engine, &one, &id, &accepted));
+        CHECK(!accepted);
+        voprf_job_t big = EvaluateJob(ctx, in, out_points, oversized);
+        accepted = true;
+        CHECK_OK(voprf_engine_try_submit(engine, &big, &id, &accepted));
+        CHECK(!accepted);
+        CHECK_OK(voprf_engine_pending(engine, &pending));
+        CHECK(pending == max_pending);
+
+        callbacks.Release();
+        voprf_job_completion_t completion = callbacks.WaitFor(1);
+        CHECK(completion.job_id == blocker_id && completion.status == 0);
+        completion = PollOne(engine);
+        CHECK(completion.job_id == fill_id && completion.status == 0);
+        WaitIdle(engine);
+
+        accepted = false;
+        CHECK_OK(voprf_engine_try_submit(engine, &big, &id, &accepted));
+        CHECK(accepted);
+        if (accepted) {
+            completion = PollOne(engine);
+            CHECK(completion.job_id == id && completion.status == 0);
+            for (size_t i = 0; i < oversized; i++) {
+                CHECK(SamePoint(out[i], expected[i]));
+            }
+        }
+
+        voprf_engine_destroy(engine);
+    }
+
+    // Runs the whole protocol for many messages through one engine, one job
+    // type at a time, against the synchronous API. Enough items that each
+    // job is split into ranges that the workers steal from one another.
+    void TestEngine() {
+        const size_t n = 500;
+        const size_t threads = 4;
+        Keys keys;
+        Messages msgs(n);
+        voprf_server_ctx_t* ctx = nullptr;
+        voprf_verifier_t* verifier = nullptr;
+        CHECK_OK(voprf_server_ctx_create(keys.sk, &ctx));
+        CHECK_OK(voprf_verifier_create(keys.pk, &verifier));
+
+        voprf_engine_t* engine = nullptr;
+        CHECK_OK(voprf_engine_create(threads, 0, &engine));
+        size_t num_threads = 0;
+        CHECK_OK(voprf_engine_num_threads(engine, &num_threads));
+        CHECK(num_threads == threads);
+        Callbacks callbacks;
+        voprf_job_completion_t completion;
+
+        // BLIND, completed by callback.
+        KeyArray factors(n);
+        PointArray blinded(n);
+        std::vector<voprf_private_key_t*> factor_ptrs(n);
+        for (size_t i = 0; i < n; i++) {
+            factor_ptrs[i] = factors[i];
+        }
+        std::vector<voprf_point_t*> blinded_out = Outputs(blinded);
+        voprf_job_t job;
+        memset(&job, 0, sizeof(job));
+        job.type = VOPRF_JOB_BLIND;
+        job.n = n;
+        job.msgs = msgs.ptrs.data();
+        job.msg_lens = msgs.lens.data();
+        job.factors = factor_ptrs.data();
+        job.out_points = blinded_out.data();
+        job.callback = Callbacks::Record;
+        job.user_data = &callbacks;
+        uint64_t id = 0;
+        CHECK_OK(voprf_engine_submit(engine, &job, &id));
+        completion = callbacks.WaitFor(1);
+        CHECK(completion.job_id == id && completion.status == 0 && completion.user_data == &callbacks);
+
+        // EVALUATE, completed by polling.
+        PointArray evaluated(n);
+        std::vector<const voprf_point_t*> blinded_in = Inputs(blinded);
+        std::vector<voprf_point_t*> evaluated_out = Outputs(evaluated);
+        int tag = 0;
+        job = EvaluateJob(ctx, blinded_in, evaluated_out, n);
+        job.user_data = &tag;
+        CHECK_OK(voprf_engine_submit(engine, &job, &id));
+        completion = PollOne(engine);
+        CHECK(completion.job_id == id && completion.status == 0 && completion.user_data == &tag);
+        for (size_t i = 0; i < n; i++) {
+            voprf_point_t* expected = nullptr;
+            CHECK_OK(voprf_evaluate(keys.sk, blinded[i], &expected));
+            CHECK(SamePoint(evaluated[i], expected));
+            voprf_point_destroy(expected);
+        }
+
+        // UNBLIND, completed by callback: the outputs are the OPRF values.
+        PointArray outputs(n);
+        std::vector<const voprf_point_t*> evaluated_in = Inputs(evaluated);
+        std::vector<voprf_point_t*> outputs_out = Outputs(outputs);
+        memset(&job, 0, sizeof(job));
+        job.type = VOPRF_JOB_UNBLIND;
+        job.n = n;
+        job.points = evaluated_in.data();
+        job.factors = factor_ptrs.data();
+        job.out_points = outputs_out.data();
+        job.callback = Callbacks::Record;
+        job.user_data = &callbacks;
+        CHECK_OK(voprf_engine_submit(engine, &job, &id));
+        completion = callbacks.WaitFor(2);
+        CHECK(completion.job_id == id && completion.status == 0);
+        for (size_t i = 0; i < n; i++) {
+            voprf_point_t* expected = Oprf(keys, msgs.text[i]);
+            CHECK(SamePoint(outputs[i], expected));
+            voprf_point_destroy(expected);
+        }
+
+        // VERIFY, completed by polling, with two outputs swapped.
+        std::vector<const voprf_point_t*> outputs_in = Inputs(outputs);
+        std::swap(outputs_in[3], outputs_in[n - 2]);
+        std::unique_ptr<bool[]> results(new bool[n]);
+        memset(&job, 0, sizeof(job));
+        job.type = VOPRF_JOB_VERIFY;
+        job.n = n;
+        job.msgs = msgs.ptrs.data();
+        job.msg_lens = msgs.lens.data();
+        job.verifier = verifier;
+        job.points = outputs_in.data();
+        job.results = results.get();
+        CHECK_OK(voprf_engine_submit(engine, &job, &id));
+        completion = PollOne(engine);
+        CHECK(completion.job_id == id && completion.status == 0);
+        for (size_t i = 0; i < n; i++) {
+            CHECK(results[i] == (i != 3 && i != n - 2));
+        }
+        size_t pending = 1;
+        CHECK_OK(voprf_engine_pending(engine, &pending));
+        CHECK(pending == 0);
+
+        // Malformed jobs are rejected before anything is queued.
+        job = EvaluateJob(ctx, blinded_in, evaluated_out, 0);
+        CHECK(voprf_engine_submit(engine, &job, &id) != 0);
+        job = EvaluateJob(nullptr, blinded_in, evaluated_out, n);
+        CHECK(voprf_engine_submit(engine, &job, &id) != 0);
+        job = EvaluateJob(ctx, blinded_in, evaluated_out, n);
+        CHECK(voprf_engine_try_submit(engine, &job, &id, nullptr) != 0);
+        voprf_engine_destroy(engine);
+
+#ifdef __linux__
+        CheckEngineFd(ctx, blinded_in, outputs);
+#endif
+        CheckEngineBackpressure(ctx, blinded_in, outputs, evaluated);
+
+        voprf_verifier_destroy(verifier);
+        voprf_server_ctx_destroy(ctx);
+    }
+
+#ifdef VOPRF_TEST_POSIX
+    // A path in the temporary directory, removed when the test ends.
+    struct TempPath {
+        std::string path;
+
+        explicit TempPath(const char* name) {
+            const char* dir = std::getenv("TMPDIR");
+            path = std::string(dir ? dir : "/tmp") + "/voprf_test_" + std::to_string(getpid()) + "_" + name;
+        }
+
+        ~TempPath() {
+            unlink(path.c_str());
+        }
+    };
+
+    std::string ReadFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const std::string& path, const std::string& data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    void TestKeyStore() {
+        const uint64_t ids[] = {42, 7, 1000};
+        Keys tenants[3];
+        const voprf_private_key_t* keys[] = {tenants[0].sk, tenants[1].sk, tenants[2].sk};
+        TempPath path("store");
+        CHECK_OK(voprf_key_store_write(path.path.c_str(), ids, keys, 3, 0));
+
+        struct stat st;
+        CHECK(stat(path.path.c_str(), &st) == 0 && (st.st_mode & 0777) == 0600);
+
+        voprf_key_store_t* store = nullptr;
+        CHECK_OK(voprf_key_store_open(path.path.c_str(), 2, &store));
+        size_t size = 0;
+        CHECK_OK(voprf_key_store_size(store, &size));
+        CHECK(size == 3);
+
+        for (size_t i = 0; i < 3; i++) {
+            voprf_private_key_t* sk = nullptr;
+            CHECK_OK(voprf_key_store_get_private_key(store, ids[i], &sk));
+            CHECK(SameKey(sk, tenants[i].sk));
+            voprf_private_key_destroy(sk);
+
+            voprf_public_key_t* pk = nullptr;
+            CHECK_OK(voprf_key_store_get_public_key(store, ids[i], &pk));
+            CHECK(SamePublicKey(pk, tenants[i].pk));
+            voprf_public_key_destroy(pk);
+        }
+
+        // Evaluation through the store matches evaluation with the key, and
+        // the result unblinds to an output the store verifies.
+        const std::string msg = "key store";
+        voprf_private_key_t* r = nullptr;
+        voprf_point_t* blinded = nullptr;
+        voprf_point_t* evaluated = nullptr;
+        voprf_point_t* expected = nullptr;
+        voprf_point_t* output = nullptr;
+        CHECK_OK(voprf_blind(reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), &r, &blinded));
+        CHECK_OK(voprf_key_store_evaluate(store, 7, blinded, &evaluated));
+        CHECK_OK(voprf_evaluate(tenants[1].sk, blinded, &expected));
+        CHECK(SamePoint(evaluated, expected));
+        CHECK_OK(voprf_unblind(evaluated, r, &output));
+        bool valid = false;
+        CHECK_OK(voprf_key_store_verify(store, 7, reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), output, &valid));
+        CHECK(valid);
+        CHECK_OK(voprf_key_store_verify(store, 42, reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), output, &valid));
+        CHECK(!valid);
+
+        // A tenant that is not in the store.
+        voprf_private_key_t* missing_sk = nullptr;
+        voprf_point_t* missing_eval = nullptr;
+        CHECK(voprf_key_store_get_private_key(store, 8, &missing_sk) != 0);
+        CHECK(voprf_key_store_evaluate(store, 8, blinded, &missing_eval) != 0);
+
+        // Rewriting the file replaces it; the open store keeps the old keys.
+        const uint64_t other_id = 7;
+        const voprf_private_key_t* other_key = tenants[2].sk;
+        CHECK_OK(voprf_key_store_write(path.path.c_str(), &other_id, &other_key, 1, 1));
+        voprf_private_key_t* sk = nullptr;
+        CHECK_OK(voprf_key_store_get_private_key(store, 7, &sk));
+        CHECK(SameKey(sk, tenants[1].sk));
+        voprf_private_key_destroy(sk);
+        voprf_key_store_close(store);
+
+        CHECK_OK(voprf_key_store_open(path.path.c_str(), 0, &store));
+        CHECK_OK(voprf_key_store_get_private_key(store, 7, &sk));
+        CHECK(SameKey(sk, tenants[2].sk));
+        voprf_private_key_destroy(sk);
+        voprf_key_store_close(store);
+
+        // Duplicate tenant IDs are rejected and leave the file alone.
+        const uint64_t dup_ids[] = {5, 5};
+        const voprf_private_key_t* dup_keys[] = {tenants[0].sk, tenants[1].sk};
+        std::string before = ReadFile(path.path);
+        CHECK(voprf_key_store_write(path.path.c_str(), dup_ids, dup_keys, 2, 1) != 0);
+        CHECK(ReadFile(path.path) == before);
+
+        // Truncated files do not open.
+        TempPath truncated("truncated");
+        for (size_t len : {before.size() - 1, size_t(10), size_t(0)}) {
+            WriteFile(truncated.path, before.substr(0, len));
+            voprf_key_store_t* bad = nullptr;
+            CHECK(voprf_key_store_open(truncated.path.c_str(), 0, &bad) != 0);
+            voprf_key_store_close(bad);
+        }
+
+        voprf_point_destroy(output);
+        voprf_point_destroy(expected);
+        voprf_point_destroy(evaluated);
+        voprf_point_destroy(blinded);
+        voprf_private_key_destroy(r);
+    }
+#endif
+}
+
+int main() {
+    if (voprf_init() != 0) {
+        std::fprintf(stderr, "voprf_init failed\n");
+        return 1;
+    }
+
+    TestVerifyBatch();
+    TestDleqProof();
+    TestBatchDleqProof();
+    TestPointsFromBytes();
+    TestTaggedPoints();
+    TestTaggedPublicKeys();
+    TestPointsToBytes();
+    TestEngine();
+#ifdef VOPRF_TEST_POSIX
+    TestKeyStore();
+#endif
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef VOPRF_SERVER_PROTOCOL_HPP
+#define VOPRF_SERVER_PROTOCOL_HPP
+
+// Wire protocol shared by voprf_server and voprf_loadgen.
+//
+// Every message is a frame: a u32 length (little-endian, not counting the
+// length field itself) followed by that many bytes.
+//
+//   request:   u32 request id | blinded point (VOPRF_POINT_BYTES)
+//   response:  u32 request id | u8 status | evaluated point (VOPRF_POINT_BYTES)
+//
+// Request ids are chosen by the client and echoed back; responses on one
+// connection may arrive in a different order from the requests. A response
+// with a non-zero status carries an all-zero point.
+
+#include "voprf/voprf.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace protocol {
+    const size_t LENGTH_BYTES = 4;
+    const size_t REQUEST_BODY_BYTES = 4 + VOPRF_POINT_BYTES;
+    const size_t RESPONSE_BODY_BYTES = 4 + 1 + VOPRF_POINT_BYTES;
+    const size_t REQUEST_FRAME_BYTES = LENGTH_BYTES + REQUEST_BODY_BYTES;
+    const size_t RESPONSE_FRAME_BYTES = LENGTH_BYTES + RESPONSE_BODY_BYTES;
+
+    enum Status : uint8_t {
+        OK = 0,
+        BAD_POINT = 1,
+        INTERNAL_ERROR = 2,
+    };
+
+    inline void PutU32(uint8_t* p, uint32_t v) {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        p[2] = static_cast<uint8_t>(v >> 16);
+        p[3] = static_cast<uint8_t>(v >> 24);
+    }
+
+    inline uint32_t GetU32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+}
+
+#endif // VOPRF_SERVER_PROTOCOL_HPP
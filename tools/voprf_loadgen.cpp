@@ -0,0 +1,261 @@
+// voprf_loadgen: a load generator for voprf_server.
+//
+// Opens --connections client connections, each driven by its own thread,
+// and keeps up to --pipeline requests in flight on every connection until
+// --requests requests have been answered in total. The blinded points are
+// generated up front so that the measurement covers only the server.
+// Reports throughput and the latency distribution on exit.
+//
+// Usage:
+//   voprf_loadgen --socket PATH [--connections C] [--requests N] [--pipeline D]
+
+#include "voprf/voprf.h"
+
+#include "server_protocol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t POOL_SIZE = 1024;
+
+    struct Options {
+        std::string socket_path;
+        size_t connections = 4;
+        size_t requests = 100000;
+        size_t pipeline = 32;
+    };
+
+    struct Result {
+        std::vector<double> latencies_us;
+        size_t errors = 0;
+        bool failed = false;
+    };
+
+    bool WriteAll(int fd, const uint8_t* p, size_t n) {
+        while (n > 0) {
+            ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                return false;
+            }
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+        return true;
+    }
+
+    bool ReadAll(int fd, uint8_t* p, size_t n) {
+        while (n > 0) {
+            ssize_t r = read(fd, p, n);
+            if (r < 0 && errno == EINTR) {
+                continue;
+            }
+            if (r <= 0) {
+                return false;
+            }
+            p += r;
+            n -= static_cast<size_t>(r);
+        }
+        return true;
+    }
+
+    int Connect(const std::string& path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size());
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Drives one connection. Requests are numbered by their slot in the
+    // pipeline window, so the send time of any response can be found
+    // directly whatever order the responses arrive in.
+    void Drive(const Options& opts, const std::vector<uint8_t>& pool, std::atomic<size_t>& remaining, Result& result) {
+        int fd = Connect(opts.socket_path);
+        if (fd < 0) {
+            std::fprintf(stderr, "voprf_loadgen: connect: %s\n", std::strerror(errno));
+            result.failed = true;
+            return;
+        }
+
+        std::vector<Clock::time_point> sent(opts.pipeline);
+        size_t next_point = 0;
+        size_t in_flight = 0;
+        uint8_t frame[protocol::REQUEST_FRAME_BYTES];
+
+        auto send_one = [&](uint32_t slot) {
+            protocol::PutU32(frame, protocol::REQUEST_BODY_BYTES);
+            protocol::PutU32(frame + 4, slot);
+            memcpy(frame + 8, pool.data() + (next_point++ % POOL_SIZE) * VOPRF_POINT_BYTES, VOPRF_POINT_BYTES);
+            sent[slot] = Clock::now();
+            in_flight++;
+            return WriteAll(fd, frame, sizeof(frame));
+        };
+
+        // Claims one request from the shared budget.
+        auto claim = [&]() {
+            size_t n = remaining.load();
+            while (n > 0 && !remaining.compare_exchange_weak(n, n - 1)) {
+            }
+            return n > 0;
+        };
+
+        for (uint32_t slot = 0; slot < opts.pipeline; slot++) {
+            if (!claim()) {
+                break;
+            }
+            if (!send_one(slot)) {
+                result.failed = true;
+                close(fd);
+                return;
+            }
+        }
+
+        uint8_t response[protocol::RESPONSE_FRAME_BYTES];
+        while (in_flight > 0) {
+            if (!ReadAll(fd, response, sizeof(response)) ||
+                protocol::GetU32(response) != protocol::RESPONSE_BODY_BYTES) {
+                result.failed = true;
+                break;
+            }
+            uint32_t slot = protocol::GetU32(response + 4);
+            if (slot >= opts.pipeline) {
+                result.failed = true;
+                break;
+            }
+            in_flight--;
+            auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - sent[slot]);
+            result.latencies_us.push_back(elapsed.count());
+            if (response[8] != protocol::OK) {
+                result.errors++;
+            }
+            if (claim() && !send_one(slot)) {
+                result.failed = true;
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    double Percentile(const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        size_t i = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+        return sorted[i];
+    }
+
+    void Usage() {
+        std::fprintf(stderr, "usage: voprf_loadgen --socket PATH [--connections C] [--requests N] [--pipeline D]\n");
+        std::exit(2);
+    }
+
+    Options Parse(int argc, char** argv) {
+        Options opts;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                Usage();
+            }
+            const char* value = argv[++i];
+            if (arg == "--socket") {
+                opts.socket_path = value;
+            } else if (arg == "--connections") {
+                opts.connections = std::strtoull(value, nullptr, 10);
+            } else if (arg == "--requests") {
+                opts.requests = std::strtoull(value, nullptr, 10);
+            } else if (arg == "--pipeline") {
+                opts.pipeline = std::strtoull(value, nullptr, 10);
+            } else {
+                Usage();
+            }
+        }
+        if (opts.socket_path.empty() || opts.connections == 0 || opts.pipeline == 0 || opts.pipeline > UINT32_MAX) {
+            Usage();
+        }
+        return opts;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opts = Parse(argc, argv);
+    if (voprf_init() != 0) {
+        std::fprintf(stderr, "voprf_loadgen: voprf_init failed\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> pool(POOL_SIZE * VOPRF_POINT_BYTES);
+    for (size_t i = 0; i < POOL_SIZE; i++) {
+        std::string msg = "voprf_loadgen " + std::to_string(i);
+        voprf_private_key_t* r = nullptr;
+        voprf_point_t* blinded = nullptr;
+        if (voprf_blind(reinterpret_cast<const uint8_t*>(msg.data()), msg.size(), &r, &blinded) != 0 ||
+            voprf_point_to_bytes(blinded, pool.data() + i * VOPRF_POINT_BYTES, VOPRF_POINT_BYTES) != 0) {
+            std::fprintf(stderr, "voprf_loadgen: blinding failed\n");
+            return 1;
+        }
+        voprf_private_key_destroy(r);
+        voprf_point_destroy(blinded);
+    }
+
+    std::atomic<size_t> remaining(opts.requests);
+    std::vector<Result> results(opts.connections);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < opts.connections; i++) {
+        threads.emplace_back(Drive, std::cref(opts), std::cref(pool), std::ref(remaining), std::ref(results[i]));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    size_t errors = 0;
+    bool failed = false;
+    for (const auto& r : results) {
+        latencies.insert(latencies.end(), r.latencies_us.begin(), r.latencies_us.end());
+        errors += r.errors;
+        failed = failed || r.failed;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::printf("requests:    %zu (%zu errors)\n", latencies.size(), errors);
+    std::printf("throughput:  %.0f req/s\n", seconds > 0 ? static_cast<double>(latencies.size()) / seconds : 0.0);
+    std::printf("latency us:  p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                Percentile(latencies, 0.50), Percentile(latencies, 0.99),
+                Percentile(latencies, 0.999), latencies.empty() ? 0.0 : latencies.back());
+    if (failed) {
+        std::fprintf(stderr, "voprf_loadgen: a connection failed before finishing\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,657 @@
+// voprf_server: a reference evaluation server on a Unix domain socket.
+//
+// One epoll thread owns every connection: it accepts clients, parses request
+// frames (see server_protocol.hpp) and writes responses back. Parsed
+// requests go onto a shared queue, from which a pool of evaluator threads
+// take micro-batches: a worker takes up to --max-batch requests, waiting at
+// most --max-wait-us after the oldest queued request arrived for the batch
+// to fill. Each batch is decoded into preallocated point arrays, evaluated
+// with one batch call and serialized with one shared normalization, then
+// handed back to the epoll thread through an eventfd. Each connection counts
+// its requests in flight; once their responses plus the output not yet
+// written reach a high-water mark, the connection stops being read, and
+// further frames wait unparsed until responses drain. A client that
+// pipelines without bound or reads slowly pushes back on its own requests
+// only.
+//
+// Usage:
+//   voprf_server --key KEY_FILE --socket PATH [--workers N]
+//                [--max-batch N] [--max-wait-us N]
+//
+// KEY_FILE holds a private key as written by voprf_private_key_to_bytes (see
+// voprf_bulk_eval --gen-key). Stop the server with SIGINT or SIGTERM.
+
+#include "voprf/voprf.h"
+
+#include "server_protocol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t READ_CHUNK = 64 * 1024;
+    const size_t OUTPUT_HIGH_WATER = 4 * 1024 * 1024;
+
+    std::atomic<bool> stopping(false);
+
+    void OnSignal(int) {
+        stopping = true;
+    }
+
+    void Check(int status, const char* what) {
+        if (status != 0) {
+            std::fprintf(stderr, "voprf_server: %s failed with status %d\n", what, status);
+            std::exit(1);
+        }
+    }
+
+    void Die(const char* what) {
+        std::fprintf(stderr, "voprf_server: %s: %s\n", what, std::strerror(errno));
+        std::exit(1);
+    }
+
+    struct Options {
+        std::string key_path;
+        std::string socket_path;
+        size_t workers = 0;
+        size_t max_batch = 64;
+        long max_wait_us = 200;
+    };
+
+    struct Request {
+        uint64_t conn;
+        uint32_t id;
+        uint8_t point[VOPRF_POINT_BYTES];
+        Clock::time_point arrival;
+    };
+
+    // Response frames for one connection, produced by one batch.
+    struct Completion {
+        uint64_t conn;
+        std::string frames;
+    };
+
+    // The queue between the epoll thread and the evaluators.
+    class BatchQueue {
+        public:
+            void Push(std::vector<Request>& requests) {
+                if (requests.empty()) {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queue.insert(queue.end(), requests.begin(), requests.end());
+                }
+                requests.clear();
+                cv.notify_all();
+            }
+
+            // Takes the next micro-batch into out. Returns false once the
+            // queue is closed and empty.
+            //
+            // Push wakes every idle worker, and all of them wait for the
+            // same batch to fill; whichever gets the lock first takes it,
+            // and the rest go back to waiting instead of returning an empty
+            // batch.
+            bool Pop(std::vector<Request>& out, size_t max_batch, std::chrono::microseconds max_wait) {
+                std::unique_lock<std::mutex> lock(mutex);
+                do {
+                    cv.wait(lock, [this] { return !queue.empty() || closed; });
+                    if (queue.empty()) {
+                        return false;
+                    }
+                    while (!queue.empty() && queue.size() < max_batch && !closed) {
+                        if (cv.wait_until(lock, queue.front().arrival + max_wait) == std::cv_status::timeout) {
+                            break;
+                        }
+                    }
+                } while (queue.empty());
+                size_t n = std::min(max_batch, queue.size());
+                out.assign(queue.begin(), queue.begin() + n);
+                queue.erase(queue.begin(), queue.begin() + n);
+                if (!queue.empty()) {
+                    cv.notify_one();
+                }
+                return true;
+            }
+
+            void Close() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    closed = true;
+                }
+                cv.notify_all();
+            }
+        private:
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::deque<Request> queue;
+            bool closed = false;
+    };
+
+    // Completed responses waiting for the epoll thread, which is woken
+    // through an eventfd.
+    class CompletionQueue {
+        public:
+            CompletionQueue() {
+                fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (fd < 0) {
+                    Die("eventfd");
+                }
+            }
+
+            ~CompletionQueue() {
+                close(fd);
+            }
+
+            int Fd() const {
+                return fd;
+            }
+
+            void Push(std::vector<Completion>& completions) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (auto& c : completions) {
+                        pending.push_back(std::move(c));
+                    }
+                }
+                completions.clear();
+                uint64_t one = 1;
+                ssize_t n = write(fd, &one, sizeof(one));
+                (void)n;
+            }
+
+            void Drain(std::vector<Completion>& out) {
+                uint64_t count;
+                ssize_t n = read(fd, &count, sizeof(count));
+                (void)n;
+                std::lock_guard<std::mutex> lock(mutex);
+                out.swap(pending);
+            }
+        private:
+            int fd;
+            std::mutex mutex;
+            std::vector<Completion> pending;
+    };
+
+    // Caller-provided storage for n point objects, reused across batches.
+    class PointArray {
+        public:
+            explicit PointArray(size_t n): n(n) {
+                size_t size = voprf_point_sizeof() * n;
+                storage.resize(size + voprf_point_alignof());
+                void* p = storage.data();
+                size_t space = storage.size();
+                std::align(voprf_point_alignof(), size, p, space);
+                Check(voprf_point_array_init(p, space, n, &array), "voprf_point_array_init");
+            }
+
+            ~PointArray() {
+                voprf_point_array_deinit(array, n);
+            }
+
+            PointArray(const PointArray&) = delete;
+            PointArray& operator=(const PointArray&) = delete;
+
+            voprf_point_t* At(size_t i) {
+                return voprf_point_array_at(array, i);
+            }
+        private:
+            size_t n;
+            std::vector<uint8_t> storage;
+            voprf_point_t* array = nullptr;
+    };
+
+    struct WorkerStats {
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> requests{0};
+    };
+
+    void Evaluate(const voprf_server_ctx_t* ctx, const Options& opts, BatchQueue& requests, CompletionQueue& completions, WorkerStats& stats) {
+        PointArray in(opts.max_batch);
+        PointArray out(opts.max_batch);
+        std::vector<voprf_point_t*> in_ptrs(opts.max_batch);
+        std::vector<voprf_point_t*> out_ptrs(opts.max_batch);
+        std::vector<size_t> good(opts.max_batch);
+        std::vector<uint8_t> status(opts.max_batch);
+        std::vector<uint8_t> encoded(opts.max_batch * VOPRF_POINT_BYTES);
+        std::vector<Request> batch;
+        std::vector<Completion> done;
+        std::unordered_map<uint64_t, size_t> by_conn;
+
+        while (requests.Pop(batch, opts.max_batch, std::chrono::microseconds(opts.max_wait_us))) {
+            size_t m = 0;
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (voprf_point_from_bytes_into(in.At(m), batch[i].point, VOPRF_POINT_BYTES) != 0) {
+                    status[i] = protocol::BAD_POINT;
+                    continue;
+                }
+                status[i] = protocol::OK;
+                in_ptrs[m] = in.At(m);
+                out_ptrs[m] = out.At(m);
+                good[m++] = i;
+            }
+            if (m > 0 &&
+                (voprf_server_ctx_evaluate_batch_into(ctx, in_ptrs.data(), m, out_ptrs.data(), 1) != 0 ||
+                 voprf_points_to_bytes(out_ptrs.data(), m, VOPRF_FORMAT_COMPRESSED, encoded.data(), encoded.size(), 1) != 0)) {
+                for (size_t j = 0; j < m; j++) {
+                    status[good[j]] = protocol::INTERNAL_ERROR;
+                }
+            }
+
+            // One completion per connection in the batch.
+            by_conn.clear();
+            std::vector<size_t> slot(batch.size());
+            for (size_t i = 0; i < batch.size(); i++) {
+                auto it = by_conn.find(batch[i].conn);
+                if (it == by_conn.end()) {
+                    it = by_conn.emplace(batch[i].conn, done.size()).first;
+                    done.push_back(Completion{batch[i].conn, std::string()});
+                }
+                slot[i] = it->second;
+            }
+            size_t j = 0;
+            for (size_t i = 0; i < batch.size(); i++) {
+                uint8_t frame[protocol::RESPONSE_FRAME_BYTES];
+                memset(frame, 0, sizeof(frame));
+                protocol::PutU32(frame, protocol::RESPONSE_BODY_BYTES);
+                protocol::PutU32(frame + 4, batch[i].id);
+                frame[8] = status[i];
+                if (j < m && good[j] == i) {
+                    if (status[i] == protocol::OK) {
+                        memcpy(frame + 9, encoded.data() + j * VOPRF_POINT_BYTES, VOPRF_POINT_BYTES);
+                    }
+                    j++;
+                }
+                done[slot[i]].frames.append(reinterpret_cast<const char*>(frame), sizeof(frame));
+            }
+            completions.Push(done);
+
+            stats.batches++;
+            stats.requests += batch.size();
+        }
+    }
+
+    struct Connection {
+        int fd;
+        std::string in;
+        std::string out;
+        size_t in_flight = 0; // queued or being evaluated
+        bool reading = true;
+        bool writing = false;
+    };
+
+    // Whether the responses a connection owes, written or not, have reached
+    // the high-water mark.
+    bool Full(const Connection& c) {
+        return c.in_flight * protocol::RESPONSE_FRAME_BYTES + c.out.size() >= OUTPUT_HIGH_WATER;
+    }
+
+    class Server {
+        public:
+            Server(const Options& opts, BatchQueue& requests, CompletionQueue& completions):
+                opts(opts), requests(requests), completions(completions) {}
+
+            void Run() {
+                Listen();
+                epfd = epoll_create1(EPOLL_CLOEXEC);
+                if (epfd < 0) {
+                    Die("epoll_create1");
+                }
+                Watch(listen_fd, EPOLLIN, LISTEN_TAG);
+                Watch(completions.Fd(), EPOLLIN, COMPLETION_TAG);
+
+                std::vector<epoll_event> events(256);
+                while (!stopping) {
+                    int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+                    if (n < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        Die("epoll_wait");
+                    }
+                    for (int i = 0; i < n; i++) {
+                        uint64_t tag = events[i].data.u64;
+                        if (tag == LISTEN_TAG) {
+                            Accept();
+                        } else if (tag == COMPLETION_TAG) {
+                            Complete();
+                        } else {
+                            Service(tag, events[i].events);
+                        }
+                    }
+                }
+
+                for (auto& c : conns) {
+                    close(c.second.fd);
+                }
+                close(epfd);
+                close(listen_fd);
+                unlink(opts.socket_path.c_str());
+            }
+        private:
+            static const uint64_t LISTEN_TAG = 0;
+            static const uint64_t COMPLETION_TAG = 1;
+
+            void Listen() {
+                sockaddr_un addr;
+                memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                if (opts.socket_path.size() >= sizeof(addr.sun_path)) {
+                    std::fprintf(stderr, "voprf_server: socket path too long\n");
+                    std::exit(1);
+                }
+                memcpy(addr.sun_path, opts.socket_path.c_str(), opts.socket_path.size());
+                unlink(opts.socket_path.c_str());
+
+                listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                if (listen_fd < 0) {
+                    Die("socket");
+                }
+                if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                    Die("bind");
+                }
+                if (listen(listen_fd, SOMAXCONN) != 0) {
+                    Die("listen");
+                }
+            }
+
+            void Watch(int fd, uint32_t events, uint64_t tag) {
+                epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events = events;
+                ev.data.u64 = tag;
+                if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                    Die("epoll_ctl");
+                }
+            }
+
+            void Update(uint64_t id, Connection& c) {
+                epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events = (c.reading ? uint32_t(EPOLLIN) : 0u) | (c.writing ? uint32_t(EPOLLOUT) : 0u);
+                ev.data.u64 = id;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+            }
+
+            void Accept() {
+                while (true) {
+                    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (fd < 0) {
+                        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                            std::fprintf(stderr, "voprf_server: accept: %s\n", std::strerror(errno));
+                        }
+                        return;
+                    }
+                    uint64_t id = next_id++;
+                    conns[id] = Connection{fd, std::string(), std::string()};
+                    Watch(fd, EPOLLIN, id);
+                }
+            }
+
+            void Drop(uint64_t id) {
+                auto it = conns.find(id);
+                if (it != conns.end()) {
+                    close(it->second.fd);
+                    conns.erase(it);
+                }
+            }
+
+            void Service(uint64_t id, uint32_t events) {
+                auto it = conns.find(id);
+                if (it == conns.end()) {
+                    return;
+                }
+                Connection& c = it->second;
+                if (events & (EPOLLERR | EPOLLHUP)) {
+                    Drop(id);
+                    return;
+                }
+                if ((events & EPOLLIN) && !Read(id, c)) {
+                    Drop(id);
+                    return;
+                }
+                if ((events & EPOLLOUT) && !Flush(id, c)) {
+                    Drop(id);
+                }
+            }
+
+            // Reads and queues requests until the socket is drained or the
+            // connection is full. Returns false if the connection should be
+            // closed.
+            bool Read(uint64_t id, Connection& c) {
+                char buf[READ_CHUNK];
+                while (!Full(c)) {
+                    ssize_t n = read(c.fd, buf, sizeof(buf));
+                    if (n > 0) {
+                        c.in.append(buf, static_cast<size_t>(n));
+                        if (!Parse(id, c)) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    if (n == 0) {
+                        return false;
+                    }
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        break;
+                    }
+                    return false;
+                }
+                requests.Push(parsed);
+                Interest(id, c);
+                return true;
+            }
+
+            // Moves complete frames from the input buffer to the parsed
+            // list until the connection is full; the rest stays buffered
+            // until responses drain. Returns false on a malformed frame.
+            bool Parse(uint64_t id, Connection& c) {
+                Clock::time_point now = Clock::now();
+                size_t pos = 0;
+                while (!Full(c) && c.in.size() - pos >= protocol::LENGTH_BYTES) {
+                    const uint8_t* p = reinterpret_cast<const uint8_t*>(c.in.data()) + pos;
+                    if (protocol::GetU32(p) != protocol::REQUEST_BODY_BYTES) {
+                        return false;
+                    }
+                    if (c.in.size() - pos < protocol::REQUEST_FRAME_BYTES) {
+                        break;
+                    }
+                    Request r;
+                    r.conn = id;
+                    r.id = protocol::GetU32(p + 4);
+                    memcpy(r.point, p + 8, VOPRF_POINT_BYTES);
+                    r.arrival = now;
+                    parsed.push_back(r);
+                    c.in_flight++;
+                    pos += protocol::REQUEST_FRAME_BYTES;
+                }
+                c.in.erase(0, pos);
+                return true;
+            }
+
+            // Watches for input while the connection has room and for
+            // writability while output is pending.
+            void Interest(uint64_t id, Connection& c) {
+                bool writing = !c.out.empty();
+                bool reading = !Full(c);
+                if (writing != c.writing || reading != c.reading) {
+                    c.writing = writing;
+                    c.reading = reading;
+                    Update(id, c);
+                }
+            }
+
+            // Writes as much pending output as the socket takes, queues any
+            // held-back requests there is now room for and adjusts the
+            // connection's interest set. Returns false on error.
+            bool Flush(uint64_t id, Connection& c) {
+                size_t pos = 0;
+                while (pos < c.out.size()) {
+                    ssize_t n = send(c.fd, c.out.data() + pos, c.out.size() - pos, MSG_NOSIGNAL);
+                    if (n > 0) {
+                        pos += static_cast<size_t>(n);
+                        continue;
+                    }
+                    if (n < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                        break;
+                    }
+                    return false;
+                }
+                c.out.erase(0, pos);
+
+                // Frames held back while the connection was full go out as
+                // soon as there is room again.
+                if (!Parse(id, c)) {
+                    return false;
+                }
+                requests.Push(parsed);
+                Interest(id, c);
+                return true;
+            }
+
+            void Complete() {
+                completions.Drain(finished);
+                for (auto& f : finished) {
+                    auto it = conns.find(f.conn);
+                    if (it == conns.end()) {
+                        continue; // the client went away
+                    }
+                    it->second.in_flight -= f.frames.size() / protocol::RESPONSE_FRAME_BYTES;
+                    it->second.out.append(f.frames);
+                    if (!Flush(f.conn, it->second)) {
+                        Drop(f.conn);
+                    }
+                }
+                finished.clear();
+            }
+
+            const Options& opts;
+            BatchQueue& requests;
+            CompletionQueue& completions;
+            int listen_fd = -1;
+            int epfd = -1;
+            uint64_t next_id = 2; // 0 and 1 are the listener and eventfd tags
+            std::unordered_map<uint64_t, Connection> conns;
+            std::vector<Request> parsed;
+            std::vector<Completion> finished;
+    };
+
+    void Usage() {
+        std::fprintf(stderr,
+                     "usage: voprf_server --key KEY_FILE --socket PATH [--workers N]\n"
+                     "                    [--max-batch N] [--max-wait-us N]\n");
+        std::exit(2);
+    }
+
+    Options Parse(int argc, char** argv) {
+        Options opts;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                Usage();
+            }
+            const char* value = argv[++i];
+            if (arg == "--key") {
+                opts.key_path = value;
+            } else if (arg == "--socket") {
+                opts.socket_path = value;
+            } else if (arg == "--workers") {
+                opts.workers = std::strtoull(value, nullptr, 10);
+            } else if (arg == "--max-batch") {
+                opts.max_batch = std::strtoull(value, nullptr, 10);
+            } else if (arg == "--max-wait-us") {
+                opts.max_wait_us = std::strtol(value, nullptr, 10);
+            } else {
+                Usage();
+            }
+        }
+        if (opts.key_path.empty() || opts.socket_path.empty() || opts.max_batch == 0 || opts.max_wait_us < 0) {
+            Usage();
+        }
+        if (opts.workers == 0) {
+            opts.workers = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return opts;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opts = Parse(argc, argv);
+    Check(voprf_init(), "voprf_init");
+
+    uint8_t key_buf[VOPRF_PRIVATE_KEY_BYTES];
+    FILE* f = std::fopen(opts.key_path.c_str(), "rb");
+    if (!f || std::fread(key_buf, 1, sizeof(key_buf), f) != sizeof(key_buf)) {
+        std::fprintf(stderr, "voprf_server: cannot read key from %s\n", opts.key_path.c_str());
+        return 1;
+    }
+    std::fclose(f);
+
+    voprf_private_key_t* sk = nullptr;
+    voprf_server_ctx_t* ctx = nullptr;
+    Check(voprf_private_key_from_bytes(&sk, key_buf, sizeof(key_buf)), "key deserialization");
+    Check(voprf_server_ctx_create(sk, &ctx), "server context");
+    voprf_private_key_destroy(sk);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    BatchQueue requests;
+    CompletionQueue completions;
+    WorkerStats stats;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < opts.workers; i++) {
+        workers.emplace_back(Evaluate, ctx, std::cref(opts), std::ref(requests), std::ref(completions), std::ref(stats));
+    }
+
+    std::fprintf(stderr, "voprf_server: listening on %s (%zu workers, max batch %zu, max wait %ld us)\n",
+                 opts.socket_path.c_str(), opts.workers, opts.max_batch, opts.max_wait_us);
+    Server server(opts, requests, completions);
+    server.Run();
+
+    requests.Close();
+    for (auto& t : workers) {
+        t.join();
+    }
+    voprf_server_ctx_destroy(ctx);
+
+    uint64_t batches = stats.batches;
+    uint64_t served = stats.requests;
+    std::fprintf(stderr, "voprf_server: %llu requests in %llu batches (mean batch %.1f)\n",
+                 static_cast<unsigned long long>(served), static_cast<unsigned long long>(batches),
+                 batches ? static_cast<double>(served) / static_cast<double>(batches) : 0.0);
+    return 0;
+}